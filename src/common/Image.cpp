@@ -1,6 +1,8 @@
 #include "Image.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 #include <stdexcept>
 
 namespace vmc
@@ -53,4 +55,11 @@ namespace vmc
 	{
 		return data;
 	}
+
+	void writePng(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgbaData)
+	{
+		if (!stbi_write_png(path.c_str(), (int)width, (int)height, 4, rgbaData, (int)width * 4)) {
+			throw std::runtime_error("Cannot write image " + path + ".");
+		}
+	}
 }
@@ -34,4 +34,6 @@ namespace vmc
 
 		uint32_t channels = 0;
 	};
+
+	void writePng(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgbaData);
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "Profiler.h"
+#include "Log.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace vmc
+{
+	struct ProfilerThreadBuffer
+	{
+		std::vector<ProfileEvent> events;
+		std::atomic<uint64_t> eventCount{ 0 };
+		uint32_t threadId = 0;
+		std::string threadName;
+		uint64_t lastFrameNs = 0;
+	};
+
+	std::atomic<bool> profilerEnabled{ false };
+
+	// Buffers outlive their threads, so the events of finished workers can still be written out.
+	static std::mutex profilerMutex;
+	static std::vector<std::unique_ptr<ProfilerThreadBuffer>> profilerBuffers;
+	static thread_local ProfilerThreadBuffer* threadBuffer = nullptr;
+
+	static ProfilerThreadBuffer& getThreadBuffer()
+	{
+		if (!threadBuffer) {
+			auto buffer = std::make_unique<ProfilerThreadBuffer>();
+			buffer->events.resize(ProfilerEventCapacity);
+
+			std::lock_guard<std::mutex> lock(profilerMutex);
+			buffer->threadId = (uint32_t)profilerBuffers.size() + 1;
+			buffer->threadName = "thread " + std::to_string(buffer->threadId);
+			threadBuffer = buffer.get();
+			profilerBuffers.push_back(std::move(buffer));
+		}
+
+		return *threadBuffer;
+	}
+
+	static void writeJsonString(std::ofstream& file, const std::string& value)
+	{
+		file << '"';
+		for (char c : value) {
+			if (c == '"' || c == '\\') {
+				file << '\\' << c;
+			}
+			else if ((unsigned char)c >= 0x20) {
+				file << c;
+			}
+		}
+		file << '"';
+	}
+
+	void setProfilerEnabled(bool isEnabled)
+	{
+		profilerEnabled.store(isEnabled, std::memory_order_relaxed);
+	}
+
+	uint64_t getProfilerTime()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void recordProfileEvent(const char* name, uint64_t beginNs, uint64_t endNs)
+	{
+		// Only the owning thread writes to a buffer, the count is published last so a reader never sees a partial event.
+		auto& buffer = getThreadBuffer();
+		uint64_t index = buffer.eventCount.load(std::memory_order_relaxed);
+
+		auto& event = buffer.events[index % ProfilerEventCapacity];
+		event.name = name;
+		event.beginNs = beginNs;
+		event.endNs = endNs;
+
+		buffer.eventCount.store(index + 1, std::memory_order_release);
+	}
+
+	void setProfilerThreadName(const std::string& name)
+	{
+		auto& buffer = getThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(profilerMutex);
+		buffer.threadName = name;
+	}
+
+	void markProfilerFrame()
+	{
+		auto& buffer = getThreadBuffer();
+		uint64_t now = getProfilerTime();
+
+		// The first marker after enabling the profiler only starts the frame.
+		if (isProfilerEnabled() && buffer.lastFrameNs != 0) {
+			recordProfileEvent("frame", buffer.lastFrameNs, now);
+		}
+		buffer.lastFrameNs = isProfilerEnabled() ? now : 0;
+	}
+
+	void clearProfiler()
+	{
+		std::lock_guard<std::mutex> lock(profilerMutex);
+		for (auto& buffer : profilerBuffers) {
+			buffer->eventCount.store(0, std::memory_order_relaxed);
+			buffer->lastFrameNs = 0;
+		}
+	}
+
+	void writeChromeTrace(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(profilerMutex);
+
+		// Timestamps are written relative to the oldest event still held by any buffer.
+		uint64_t epochNs = UINT64_MAX;
+		size_t eventCount = 0;
+		for (const auto& buffer : profilerBuffers) {
+			uint64_t count = buffer->eventCount.load(std::memory_order_acquire);
+			uint64_t first = count > ProfilerEventCapacity ? count - ProfilerEventCapacity : 0;
+			for (uint64_t i = first; i < count; i++) {
+				epochNs = std::min(epochNs, buffer->events[i % ProfilerEventCapacity].beginNs);
+			}
+			eventCount += (size_t)(count - first);
+		}
+
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open()) {
+			loge("Cannot write trace %s.", path.c_str());
+			return;
+		}
+
+		file << std::fixed << std::setprecision(3);
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		bool isFirstEvent = true;
+		for (const auto& buffer : profilerBuffers) {
+			file << (isFirstEvent ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+			writeJsonString(file, buffer->threadName);
+			file << "}}";
+			isFirstEvent = false;
+
+			uint64_t count = buffer->eventCount.load(std::memory_order_acquire);
+			uint64_t first = count > ProfilerEventCapacity ? count - ProfilerEventCapacity : 0;
+			for (uint64_t i = first; i < count; i++) {
+				const auto& event = buffer->events[i % ProfilerEventCapacity];
+				file << ",\n{\"name\":";
+				writeJsonString(file, event.name);
+				file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+					<< ",\"ts\":" << (event.beginNs - epochNs) / 1000.0
+					<< ",\"dur\":" << (event.endNs - event.beginNs) / 1000.0 << "}";
+			}
+		}
+
+		file << "\n]}\n";
+		logd("Wrote %zu trace events to %s.", eventCount, path.c_str());
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+namespace vmc
+{
+	const uint32_t ProfilerEventCapacity = 64 * 1024;
+
+	struct ProfileEvent
+	{
+		const char* name = nullptr;
+		uint64_t beginNs = 0;
+		uint64_t endNs = 0;
+	};
+
+	extern std::atomic<bool> profilerEnabled;
+
+	// A disabled profiler costs every zone one relaxed load, so zones can stay in the code permanently.
+	inline bool isProfilerEnabled()
+	{
+		return profilerEnabled.load(std::memory_order_relaxed);
+	}
+
+	void setProfilerEnabled(bool isEnabled);
+
+	uint64_t getProfilerTime();
+
+	// Every thread records into its own ring buffer, which keeps the most recent ProfilerEventCapacity events. Names
+	// are stored as pointers and have to outlive the profiler, in practice they are string literals.
+	void recordProfileEvent(const char* name, uint64_t beginNs, uint64_t endNs);
+
+	void setProfilerThreadName(const std::string& name);
+
+	// Records the time since the previous marker of the calling thread as a frame.
+	void markProfilerFrame();
+
+	void clearProfiler();
+
+	// Writes the Chrome trace event format, which chrome://tracing and Perfetto open. No other thread may record events
+	// while the trace is written.
+	void writeChromeTrace(const std::string& path);
+
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(const char* name) :
+			name(isProfilerEnabled() ? name : nullptr),
+			beginNs(this->name ? getProfilerTime() : 0)
+		{
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+
+		ProfileZone(ProfileZone&& other) = delete;
+
+		~ProfileZone()
+		{
+			if (name) {
+				recordProfileEvent(name, beginNs, getProfilerTime());
+			}
+		}
+
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+		ProfileZone& operator=(ProfileZone&&) = delete;
+
+	private:
+		const char* name;
+
+		uint64_t beginNs;
+	};
+}
+
+#define VMC_PROFILE_CONCAT_INNER(a, b) a##b
+#define VMC_PROFILE_CONCAT(a, b) VMC_PROFILE_CONCAT_INNER(a, b)
+#define VMC_PROFILE_ZONE(name) ::vmc::ProfileZone VMC_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define VMC_PROFILE_FRAME() ::vmc::markProfilerFrame()
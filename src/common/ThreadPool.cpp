@@ -0,0 +1,106 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace vmc
+{
+	uint32_t getDefaultWorkerThreadCount()
+	{
+		// One core is left to the main thread, which only waits while a batch runs but keeps the driver busy in between.
+		uint32_t coreCount = std::thread::hardware_concurrency();
+		return std::min(std::max(coreCount, 2u) - 1, DefaultMaxWorkerThreads);
+	}
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		threadCount = std::max(threadCount, 1u);
+		for (uint32_t i = 0; i < threadCount; i++) {
+			threads.emplace_back(&ThreadPool::workerLoop, this, i);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			isStopping = true;
+		}
+
+		workAvailable.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void ThreadPool::run(uint32_t taskCount, const std::function<void(uint32_t)>& task)
+	{
+		if (taskCount == 0) {
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		currentTask = &task;
+		this->taskCount = taskCount;
+		nextTaskIndex = 0;
+		finishedTaskCount = 0;
+		taskException = nullptr;
+		batchIndex++;
+
+		workAvailable.notify_all();
+		workFinished.wait(lock, [this] { return finishedTaskCount == this->taskCount; });
+		currentTask = nullptr;
+
+		if (taskException) {
+			auto exception = taskException;
+			taskException = nullptr;
+			std::rethrow_exception(exception);
+		}
+	}
+
+	uint32_t ThreadPool::getThreadCount() const
+	{
+		return (uint32_t)threads.size();
+	}
+
+	void ThreadPool::workerLoop(uint32_t threadIndex)
+	{
+		setProfilerThreadName("worker " + std::to_string(threadIndex));
+
+		uint64_t lastBatchIndex = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true) {
+			workAvailable.wait(lock, [&] { return isStopping || (batchIndex != lastBatchIndex && nextTaskIndex < taskCount); });
+			if (isStopping) {
+				return;
+			}
+
+			// Tasks are handed out one at a time, so a worker that finishes early picks up the remaining ones.
+			while (nextTaskIndex < taskCount) {
+				uint32_t taskIndex = nextTaskIndex++;
+				const auto& task = *currentTask;
+
+				lock.unlock();
+				std::exception_ptr exception;
+				try {
+					VMC_PROFILE_ZONE("worker task");
+					task(taskIndex);
+				}
+				catch (...) {
+					exception = std::current_exception();
+				}
+				lock.lock();
+
+				if (exception && !taskException) {
+					taskException = exception;
+				}
+
+				if (++finishedTaskCount == taskCount) {
+					workFinished.notify_one();
+				}
+			}
+
+			lastBatchIndex = batchIndex;
+		}
+	}
+}
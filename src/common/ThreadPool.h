@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <cstdint>
+
+namespace vmc
+{
+	const uint32_t DefaultMaxWorkerThreads = 8;
+
+	uint32_t getDefaultWorkerThreadCount();
+
+	// Fixed set of worker threads executing one batch of indexed tasks at a time. The caller blocks until every task of
+	// the batch has finished, so tasks may freely reference the caller's stack.
+	class ThreadPool
+	{
+	public:
+		ThreadPool(uint32_t threadCount = getDefaultWorkerThreadCount());
+
+		ThreadPool(const ThreadPool&) = delete;
+
+		ThreadPool(ThreadPool&& other) = delete;
+
+		~ThreadPool();
+
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		void run(uint32_t taskCount, const std::function<void(uint32_t)>& task);
+
+		uint32_t getThreadCount() const;
+
+	private:
+		std::vector<std::thread> threads;
+
+		std::mutex mutex;
+
+		std::condition_variable workAvailable;
+
+		std::condition_variable workFinished;
+
+		const std::function<void(uint32_t)>* currentTask = nullptr;
+
+		uint32_t taskCount = 0;
+
+		uint32_t nextTaskIndex = 0;
+
+		uint32_t finishedTaskCount = 0;
+
+		uint64_t batchIndex = 0;
+
+		std::exception_ptr taskException;
+
+		bool isStopping = false;
+
+		void workerLoop(uint32_t threadIndex);
+	};
+}
@@ -1,17 +1,25 @@
 #include "Application.h"
 #include <stdexcept>
 #include <common/Log.h>
+#include <common/Image.h>
+#include <common/Profiler.h>
 #include <chrono>
+#include <algorithm>
 #include "GameView.h"
 
 namespace vmc
 {
 	const char* ApplicationName = "vmc";
+	const char* PipelineCachePath = "pipeline_cache.bin";
+	const char* DefaultTracePath = "trace.json";
+	const float HeadlessTimeDelta = 1.0f / 60.0f;
 
-	std::vector<const char*> getRequiredInstanceExtensions()
+	std::vector<const char*> getRequiredInstanceExtensions(bool isHeadless)
 	{
 		std::vector<const char*> extensions;
-		addWindowInstanceExtensions(extensions);
+		if (!isHeadless) {
+			addWindowInstanceExtensions(extensions);
+		}
 		return extensions;
 	}
 
@@ -21,33 +29,82 @@ namespace vmc
 		return layers;
 	}
 
-	std::vector<const char*> getRequiredDeviceExtensions()
+	std::vector<const char*> getRequiredDeviceExtensions(bool isHeadless)
+	{
+		std::vector<const char*> extensions;
+		if (!isHeadless) {
+			extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		}
+		return extensions;
+	}
+
+	float getPercentile(const std::vector<float>& sortedValues, float percentile)
+	{
+		size_t index = (size_t)(percentile / 100.0f * (sortedValues.size() - 1) + 0.5f);
+		return sortedValues[std::min(index, sortedValues.size() - 1)];
+	}
+
+	void logGpuTimings(const std::vector<GpuTiming>& timings)
+	{
+		for (const auto& timing : timings) {
+			logd("GPU %s: %.3f ms average, %.3f ms last.", timing.name, timing.averageMs, timing.lastMs);
+		}
+	}
+
+	std::vector<const char*> getOptionalDeviceExtensions()
 	{
 		std::vector<const char*> extensions;
-		extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
 		return extensions;
 	}
 
-	Application::Application(uint32_t windowWidth, uint32_t windowHeight)
+	Application::Application(const ApplicationSettings& settings) :
+		settings(settings),
+		startupBegin(std::chrono::high_resolution_clock::now())
 	{
-		auto requiredInstanceExtensions = getRequiredInstanceExtensions();
+		// A trace requested on the command line covers the whole run, including startup.
+		setProfilerThreadName("main");
+		setProfilerEnabled(!settings.tracePath.empty());
+
+		auto requiredInstanceExtensions = getRequiredInstanceExtensions(settings.isHeadless);
 		auto requiredInstanceLayers = getRequiredInstanceLayers();
-		auto requiredDeviceExtensions = getRequiredDeviceExtensions();
+		auto requiredDeviceExtensions = getRequiredDeviceExtensions(settings.isHeadless);
+		auto optionalDeviceExtensions = getOptionalDeviceExtensions();
 
+		// A headless application has no window, surface or swapchain and renders every frame offscreen.
 		instance = std::make_unique<VulkanInstance>(ApplicationName, ApplicationName, requiredInstanceExtensions, requiredInstanceLayers);
-		window = std::make_unique<Window>(*this, *instance, windowWidth, windowHeight, ApplicationName);
-		device = std::make_unique<VulkanDevice>(instance->getBestPhysicalDevice(), window->getSurface(), requiredDeviceExtensions);
+		if (!settings.isHeadless) {
+			window = std::make_unique<Window>(*this, *instance, settings.windowWidth, settings.windowHeight, ApplicationName);
+		}
+		VkSurfaceKHR surface = window ? window->getSurface() : VK_NULL_HANDLE;
+		device = std::make_unique<VulkanDevice>(instance->getBestPhysicalDevice(), surface, requiredDeviceExtensions, optionalDeviceExtensions);
 
+		pipelineCache = std::make_unique<PipelineCache>(*device, PipelineCachePath);
+
+		// Background work is budgeted against the capped frame time, so it fills the frames instead of the limiter's wait.
+		if (settings.fpsCap > 0) {
+			frameLimiter.setTargetFps((float)settings.fpsCap);
+			frameBudget.setTargetFrameTimeMs(1000.0f / settings.fpsCap);
+		}
 		initDescriptorSetLayouts();
 
 		stagingManager = std::make_unique<StagingManager>(*device);
 		textureBundle = std::make_unique<TextureBundle>(*device, *textureLayout, *stagingManager);
-		renderPass = std::make_unique<RenderPass>(*device, device->getSurfaceFormat().format);
-		renderContext = std::make_unique<RenderContext>(*device, *window, *renderPass, *mvpLayout);
+		threadPool = std::make_unique<ThreadPool>();
+		if (settings.isHeadless) {
+			renderPass = std::make_unique<RenderPass>(*device, device->getSurfaceFormat().format, RenderPassStage::Complete, OffscreenColorLayout);
+			renderContext = std::make_unique<RenderContext>(*device, settings.windowWidth, settings.windowHeight, *renderPass, *mvpLayout, settings.framesInFlight, threadPool->getThreadCount());
+		}
+		else {
+			renderPass = std::make_unique<RenderPass>(*device, device->getSurfaceFormat().format);
+			renderContext = std::make_unique<RenderContext>(*device, *window, *renderPass, *mvpLayout, settings.framesInFlight, settings.presentMode, threadPool->getThreadCount());
+		}
 
 		textureBundle->add("main_atlas", "data/images/main_atlas.png", 4);
+		textureBundle->add("font", "data/images/font.png");
         blockDescriptions = loadBlockDescriptions("data/blocks.json");
-        meshBuilder = std::make_unique<MeshBuilder>(*device, blockDescriptions);
+        meshPool = std::make_unique<MeshPool>(*device, sizeof(BlockVertex));
+        meshBuilder = std::make_unique<MeshBuilder>(*device, *meshPool, blockDescriptions);
 	}
 
 	Application::~Application()
@@ -58,16 +115,25 @@ namespace vmc
 
 		currentView.reset();
 		renderContext.reset();
+		threadPool.reset();
+		meshBuilder.reset();
+		meshPool.reset();
 		renderPass.reset();
 		textureBundle.reset();
 		stagingManager.reset();
 		mvpLayout.reset();
 		textureLayout.reset();
+		pipelineCache.reset();
 		device.reset();
 		window.reset();
 		instance.reset();
 	}
 
+	const ApplicationSettings& Application::getSettings() const
+	{
+		return settings;
+	}
+
 	const RenderPass& Application::getRenderPass() const
 	{
 		return *renderPass;
@@ -78,6 +144,11 @@ namespace vmc
 		return *device;
 	}
 
+	const PipelineCache& Application::getPipelineCache() const
+	{
+		return *pipelineCache;
+	}
+
 	StagingManager& Application::getStagingManager()
 	{
 		return *stagingManager;
@@ -103,6 +174,11 @@ namespace vmc
         return blockDescriptions;
     }
 
+    MeshPool& Application::getMeshPool()
+    {
+        return *meshPool;
+    }
+
     MeshBuilder& Application::getMeshBuilder()
     {
         return *meshBuilder;
@@ -113,15 +189,51 @@ namespace vmc
 		return fps;
 	}
 
+	RenderContext& Application::getRenderContext()
+	{
+		return *renderContext;
+	}
+
+	FrameBudget& Application::getFrameBudget()
+	{
+		return frameBudget;
+	}
+
+	ThreadPool& Application::getThreadPool()
+	{
+		return *threadPool;
+	}
+
     Window& Application::getWindow()
     {
 		return *window;
     }
 
+	bool Application::isHeadless() const
+	{
+		return !window;
+	}
+
 	void Application::run()
 	{
 		currentView = std::make_unique<GameView>(*this);
-		mainLoop();
+
+		// Every pipeline exists once the first view is created, so the cache is complete at this point.
+		auto startupMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startupBegin).count();
+		logd("Startup took %.1f ms with a %s pipeline cache.", startupMs, pipelineCache->isWarm() ? "warm" : "cold");
+		pipelineCache->save();
+
+		if (isHeadless()) {
+			runHeadless();
+		}
+		else {
+			mainLoop();
+		}
+
+		if (isProfilerEnabled()) {
+			setProfilerEnabled(false);
+			writeChromeTrace(getTracePath());
+		}
 	}
 
 	void Application::onWindowResize(uint32_t newWidth, uint32_t newHeight)
@@ -134,7 +246,7 @@ namespace vmc
 		uniformBinding.binding = 0;
 		uniformBinding.descriptorCount = 1;
 		uniformBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-		uniformBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		uniformBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
 		mvpLayout = std::make_unique<DescriptorSetLayout>(*device, std::vector<VkDescriptorSetLayoutBinding>{ uniformBinding });
 
@@ -154,13 +266,31 @@ namespace vmc
 		auto lastTime = std::chrono::high_resolution_clock::now();
 		long long nanosecondsSinceFPSUpdate = 0;
 		uint32_t frameCounter = 0;
+		float idleTimeMs = 0.0f;
 
 		while (!window->shouldClose()) {
+			// Nothing is rendered without focus, so a low-power loop sleeps until the window system reports an event, and
+			// the time spent asleep is not simulated afterwards.
+			if (settings.isLowPowerEnabled && !window->isFocused()) {
+				auto waitStart = std::chrono::high_resolution_clock::now();
+				window->waitEvents();
+				lastTime = std::chrono::high_resolution_clock::now();
+				idleTimeMs += std::chrono::duration<float, std::milli>(lastTime - waitStart).count();
+				continue;
+			}
+
+			VMC_PROFILE_FRAME();
 			auto currentTime = std::chrono::high_resolution_clock::now();
 			auto elapsedNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(currentTime - lastTime).count();
 			double elapsedSeconds = elapsedNanoseconds / (double)NanosecondsInSecond;
 
+			frameBudget.beginFrame(idleTimeMs);
 			window->pollEvents();
+			stagingManager->update();
+
+			if (window->isKeyJustPressed(GLFW_KEY_F8)) {
+				toggleTraceCapture();
+			}
 
 			if (currentView) {
 				currentView->update(elapsedSeconds);
@@ -178,6 +308,68 @@ namespace vmc
 			}
 
 			lastTime = currentTime;
+
+			VMC_PROFILE_ZONE("frame limiter");
+			idleTimeMs = frameLimiter.wait();
+		}
+	}
+
+	std::string Application::getTracePath() const
+	{
+		return settings.tracePath.empty() ? DefaultTracePath : settings.tracePath;
+	}
+
+	void Application::toggleTraceCapture()
+	{
+		// Each capture starts from empty buffers, so the trace only holds the frames between the two key presses.
+		if (!isProfilerEnabled()) {
+			clearProfiler();
+			setProfilerEnabled(true);
+			logd("Started trace capture.");
+		}
+		else {
+			setProfilerEnabled(false);
+			writeChromeTrace(getTracePath());
+		}
+	}
+
+	void Application::runHeadless()
+	{
+		// Every frame simulates the same time step, so a benchmark run is repeatable and only the measured times vary.
+		std::vector<float> frameTimesMs;
+		frameTimesMs.reserve(settings.headlessFrameCount);
+
+		auto runBegin = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < settings.headlessFrameCount; i++) {
+			VMC_PROFILE_FRAME();
+			auto frameBegin = std::chrono::high_resolution_clock::now();
+
+			frameBudget.beginFrame();
+			stagingManager->update();
+
+			if (currentView) {
+				currentView->update(HeadlessTimeDelta);
+				currentView->render(*renderContext);
+			}
+
+			frameTimesMs.push_back(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - frameBegin).count());
+		}
+
+		// Frames still executing count towards the total, which is what bounds the throughput.
+		device->waitIdle();
+		auto totalMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - runBegin).count();
+
+		auto sortedTimesMs = frameTimesMs;
+		std::sort(sortedTimesMs.begin(), sortedTimesMs.end());
+		logd("Rendered %u headless frames at %ux%u in %.1f ms, %.1f fps.", settings.headlessFrameCount, renderContext->getWidth(), renderContext->getHeight(), totalMs, settings.headlessFrameCount * 1000.0f / totalMs);
+		logd("Frame time: min %.2f ms, median %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms.", sortedTimesMs.front(), getPercentile(sortedTimesMs, 50.0f), getPercentile(sortedTimesMs, 95.0f), getPercentile(sortedTimesMs, 99.0f), sortedTimesMs.back());
+		logGpuTimings(renderContext->getGpuProfiler().getTimings());
+		logGpuTimings(stagingManager->getGpuTimings());
+
+		if (!settings.screenshotPath.empty()) {
+			auto pixels = renderContext->readLastFrame();
+			writePng(settings.screenshotPath, renderContext->getWidth(), renderContext->getHeight(), pixels.data());
+			logd("Saved the last frame to %s.", settings.screenshotPath.c_str());
 		}
 	}
 }
\ No newline at end of file
@@ -1,13 +1,19 @@
 #pragma once
 
 #include <core/Window.h>
+#include <core/FrameBudget.h>
+#include <core/FrameLimiter.h>
+#include <core/ApplicationSettings.h>
 #include <vk/VulkanDevice.h>
 #include <vk/VulkanInstance.h>
 #include <vk/StagingManager.h>
+#include <vk/PipelineCache.h>
 #include <rendering/RenderContext.h>
 #include <rendering/TextureBundle.h>
 #include <rendering/MeshBuilder.h>
+#include <common/ThreadPool.h>
 #include <memory>
+#include <chrono>
 #include "View.h"
 
 namespace vmc
@@ -15,7 +21,7 @@ namespace vmc
 	class Application
 	{
 	public:
-		Application(uint32_t windowWidth, uint32_t windowHeight);
+		Application(const ApplicationSettings& settings);
 
 		Application(const Application&) = delete;
 
@@ -27,12 +33,18 @@ namespace vmc
 
 		Application& operator=(Application&&) = delete;
 
+		const ApplicationSettings& getSettings() const;
+
 		const RenderPass& getRenderPass() const;
 
 		const VulkanDevice& getDevice() const;
 
+		const PipelineCache& getPipelineCache() const;
+
 		StagingManager& getStagingManager();
 
+		RenderContext& getRenderContext();
+
 		const DescriptorSetLayout& getMVPLayout() const;
 
 		const DescriptorSetLayout& getTextureLayout() const;
@@ -43,25 +55,39 @@ namespace vmc
 
         MeshBuilder& getMeshBuilder();
 
+        MeshPool& getMeshPool();
+
 		uint32_t getFPS() const;
 
 		Window& getWindow();
 
+		bool isHeadless() const;
+
+		FrameBudget& getFrameBudget();
+
+		ThreadPool& getThreadPool();
+
 		void run();
 
 		void onWindowResize(uint32_t newWidth, uint32_t newHeight);
 
 	private:
+		ApplicationSettings settings;
+
 		std::unique_ptr<Window> window;
 
 		std::unique_ptr<VulkanInstance> instance;
 
 		std::unique_ptr<VulkanDevice> device;
 
+		std::unique_ptr<PipelineCache> pipelineCache;
+
 		std::unique_ptr<DescriptorSetLayout> mvpLayout;
 
 		std::unique_ptr<DescriptorSetLayout> textureLayout;
 
+		std::unique_ptr<ThreadPool> threadPool;
+
 		std::unique_ptr<TextureBundle> textureBundle;
 
 		std::unique_ptr<RenderPass> renderPass;
@@ -72,14 +98,28 @@ namespace vmc
 
         std::vector<Block> blockDescriptions;
 
+        std::unique_ptr<MeshPool> meshPool;
+
         std::unique_ptr<MeshBuilder> meshBuilder;
 
         std::unique_ptr<View> currentView;
 
+		FrameBudget frameBudget;
+
+		FrameLimiter frameLimiter;
+
 		uint32_t fps;
 
+		std::chrono::high_resolution_clock::time_point startupBegin;
+
 		void initDescriptorSetLayouts();
 
 		void mainLoop();
+
+		void runHeadless();
+
+		std::string getTracePath() const;
+
+		void toggleTraceCapture();
 	};
 }
\ No newline at end of file
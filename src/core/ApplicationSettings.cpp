@@ -0,0 +1,121 @@
+#include "ApplicationSettings.h"
+#include <stdexcept>
+#include <string>
+
+namespace vmc
+{
+	static uint32_t parseUnsigned(const std::string& option, const char* value, uint32_t min, uint32_t max)
+	{
+		if (!value) {
+			throw std::runtime_error("Cannot parse option " + option + " without a value.");
+		}
+
+		size_t length = 0;
+		unsigned long result = 0;
+		try {
+			result = std::stoul(value, &length);
+		}
+		catch (const std::exception&) {
+			length = 0;
+		}
+
+		if (length == 0 || value[length] != '\0' || result < min || result > max) {
+			throw std::runtime_error("Cannot parse option " + option + ", expected a number between " + std::to_string(min) + " and " + std::to_string(max) + ".");
+		}
+
+		return (uint32_t)result;
+	}
+
+	static VkPresentModeKHR parsePresentMode(const std::string& option, const char* value)
+	{
+		std::string name = value ? value : "";
+		if (name == "immediate") {
+			return VK_PRESENT_MODE_IMMEDIATE_KHR;
+		}
+		if (name == "mailbox") {
+			return VK_PRESENT_MODE_MAILBOX_KHR;
+		}
+		if (name == "fifo") {
+			return VK_PRESENT_MODE_FIFO_KHR;
+		}
+		if (name == "fifo-relaxed") {
+			return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+		}
+
+		throw std::runtime_error("Cannot parse option " + option + ", expected immediate, mailbox, fifo or fifo-relaxed.");
+	}
+
+	static bool parseSwitch(const std::string& option, const char* value)
+	{
+		std::string name = value ? value : "";
+		if (name == "on") {
+			return true;
+		}
+		if (name == "off") {
+			return false;
+		}
+
+		throw std::runtime_error("Cannot parse option " + option + ", expected on or off.");
+	}
+
+	ApplicationSettings parseApplicationSettings(int argc, char** argv)
+	{
+		ApplicationSettings settings;
+
+		for (int i = 1; i < argc; i++) {
+			std::string option = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+			if (option == "--width") {
+				settings.windowWidth = parseUnsigned(option, value, 1, 16384);
+				i++;
+			}
+			else if (option == "--height") {
+				settings.windowHeight = parseUnsigned(option, value, 1, 16384);
+				i++;
+			}
+			else if (option == "--frames-in-flight") {
+				settings.framesInFlight = parseUnsigned(option, value, 1, MaxFramesInFlight);
+				i++;
+			}
+			else if (option == "--present-mode") {
+				settings.presentMode = parsePresentMode(option, value);
+				i++;
+			}
+			else if (option == "--fps-cap") {
+				settings.fpsCap = parseUnsigned(option, value, 0, 1000);
+				i++;
+			}
+			else if (option == "--low-power") {
+				settings.isLowPowerEnabled = parseSwitch(option, value);
+				i++;
+			}
+			else if (option == "--headless") {
+				settings.isHeadless = true;
+			}
+			else if (option == "--frames") {
+				settings.headlessFrameCount = parseUnsigned(option, value, 1, 1000000);
+				i++;
+			}
+			else if (option == "--screenshot") {
+				if (!value) {
+					throw std::runtime_error("Cannot parse option " + option + " without a value.");
+				}
+				settings.screenshotPath = value;
+				i++;
+			}
+			else if (option == "--trace") {
+				if (!value) {
+					throw std::runtime_error("Cannot parse option " + option + " without a value.");
+				}
+				settings.tracePath = value;
+				i++;
+			}
+			else {
+				throw std::runtime_error("Cannot parse unknown option " + option + ".");
+			}
+		}
+
+		return settings;
+	}
+}
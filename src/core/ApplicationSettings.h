@@ -0,0 +1,28 @@
+#pragma once
+
+#include <volk.h>
+#include <cstdint>
+#include <string>
+
+namespace vmc
+{
+	const uint32_t DefaultFramesInFlight = 2;
+	const uint32_t MaxFramesInFlight = 4;
+	const uint32_t DefaultHeadlessFrameCount = 600;
+
+	struct ApplicationSettings
+	{
+		uint32_t windowWidth = 800;
+		uint32_t windowHeight = 600;
+		uint32_t framesInFlight = DefaultFramesInFlight;
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		uint32_t fpsCap = 0;
+		bool isLowPowerEnabled = true;
+		bool isHeadless = false;
+		uint32_t headlessFrameCount = DefaultHeadlessFrameCount;
+		std::string screenshotPath;
+		std::string tracePath;
+	};
+
+	ApplicationSettings parseApplicationSettings(int argc, char** argv);
+}
@@ -0,0 +1,115 @@
+#include "FrameBudget.h"
+#include <algorithm>
+
+namespace vmc
+{
+	const float EstimateSmoothing = 0.2f;
+
+	static float smooth(float estimate, float sample)
+	{
+		return estimate + (sample - estimate) * EstimateSmoothing;
+	}
+
+	FrameBudget::FrameBudget(float targetFrameTimeMs, float maxTaskTimeMs, uint64_t maxTaskBytes) :
+		targetFrameTimeMs(targetFrameTimeMs),
+		maxTaskTimeMs(maxTaskTimeMs),
+		maxTaskBytes(maxTaskBytes),
+		frameStart(Clock::now()),
+		taskStart(frameStart)
+	{
+	}
+
+	void FrameBudget::beginFrame(float idleTimeMs)
+	{
+		auto now = Clock::now();
+
+		if (!isFirstFrame) {
+			// Time spent waiting for the frame limiter is not work the next frame has to fit around.
+			float frameTimeMs = std::chrono::duration<float, std::milli>(now - frameStart).count() - idleTimeMs;
+			estimatedFrameWorkMs = smooth(estimatedFrameWorkMs, std::max(frameTimeMs - currentFrameStats.taskTimeMs, 0.0f));
+		}
+
+		lastFrameStats = currentFrameStats;
+		currentFrameStats = FrameBudgetStats();
+		frameStart = now;
+		isFirstFrame = false;
+	}
+
+	bool FrameBudget::canStartTask() const
+	{
+		// The first task of a frame is always admitted so that queued work keeps moving even when the frame is over budget.
+		if (currentFrameStats.tasksAdmitted == 0) {
+			return true;
+		}
+
+		if (currentFrameStats.taskTimeMs + estimatedTaskTimeMs > maxTaskTimeMs) {
+			return false;
+		}
+
+		if (currentFrameStats.taskBytes + (uint64_t)estimatedTaskBytes > maxTaskBytes) {
+			return false;
+		}
+
+		float elapsedMs = getElapsedMs();
+		float remainingFrameWorkMs = std::max(estimatedFrameWorkMs - (elapsedMs - currentFrameStats.taskTimeMs), 0.0f);
+
+		return elapsedMs + remainingFrameWorkMs + estimatedTaskTimeMs <= targetFrameTimeMs;
+	}
+
+	void FrameBudget::startTask()
+	{
+		taskStart = Clock::now();
+	}
+
+	void FrameBudget::finishTask(uint64_t bytes)
+	{
+		float taskTimeMs = std::chrono::duration<float, std::milli>(Clock::now() - taskStart).count();
+
+		currentFrameStats.tasksAdmitted++;
+		currentFrameStats.taskTimeMs += taskTimeMs;
+		currentFrameStats.taskBytes += bytes;
+
+		estimatedTaskTimeMs = smooth(estimatedTaskTimeMs, taskTimeMs);
+		estimatedTaskBytes = smooth(estimatedTaskBytes, (float)bytes);
+	}
+
+	float FrameBudget::getElapsedMs() const
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - frameStart).count();
+	}
+
+	float FrameBudget::getEstimatedTaskTimeMs() const
+	{
+		return estimatedTaskTimeMs;
+	}
+
+	uint64_t FrameBudget::getEstimatedTaskBytes() const
+	{
+		return (uint64_t)estimatedTaskBytes;
+	}
+
+	const FrameBudgetStats& FrameBudget::getCurrentFrameStats() const
+	{
+		return currentFrameStats;
+	}
+
+	const FrameBudgetStats& FrameBudget::getLastFrameStats() const
+	{
+		return lastFrameStats;
+	}
+
+	void FrameBudget::setTargetFrameTimeMs(float targetFrameTimeMs)
+	{
+		this->targetFrameTimeMs = targetFrameTimeMs;
+	}
+
+	void FrameBudget::setMaxTaskTimeMs(float maxTaskTimeMs)
+	{
+		this->maxTaskTimeMs = maxTaskTimeMs;
+	}
+
+	void FrameBudget::setMaxTaskBytes(uint64_t maxTaskBytes)
+	{
+		this->maxTaskBytes = maxTaskBytes;
+	}
+}
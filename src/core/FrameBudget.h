@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace vmc
+{
+	const float DefaultTargetFrameTimeMs = 1000.0f / 60.0f;
+	const float DefaultMaxTaskTimeMs = 6.0f;
+	const uint64_t DefaultMaxTaskBytes = 16 * 1024 * 1024;
+
+	struct FrameBudgetStats
+	{
+		uint32_t tasksAdmitted = 0;
+		float taskTimeMs = 0.0f;
+		uint64_t taskBytes = 0;
+	};
+
+	class FrameBudget
+	{
+	public:
+		FrameBudget(float targetFrameTimeMs = DefaultTargetFrameTimeMs, float maxTaskTimeMs = DefaultMaxTaskTimeMs, uint64_t maxTaskBytes = DefaultMaxTaskBytes);
+
+		void beginFrame(float idleTimeMs = 0.0f);
+
+		bool canStartTask() const;
+
+		void startTask();
+
+		void finishTask(uint64_t bytes);
+
+		float getElapsedMs() const;
+
+		float getEstimatedTaskTimeMs() const;
+
+		uint64_t getEstimatedTaskBytes() const;
+
+		const FrameBudgetStats& getCurrentFrameStats() const;
+
+		const FrameBudgetStats& getLastFrameStats() const;
+
+		void setTargetFrameTimeMs(float targetFrameTimeMs);
+
+		void setMaxTaskTimeMs(float maxTaskTimeMs);
+
+		void setMaxTaskBytes(uint64_t maxTaskBytes);
+
+	private:
+		using Clock = std::chrono::high_resolution_clock;
+
+		float targetFrameTimeMs;
+
+		float maxTaskTimeMs;
+
+		uint64_t maxTaskBytes;
+
+		Clock::time_point frameStart;
+
+		Clock::time_point taskStart;
+
+		float estimatedTaskTimeMs = 1.0f;
+
+		float estimatedTaskBytes = 0.0f;
+
+		float estimatedFrameWorkMs = 0.0f;
+
+		FrameBudgetStats currentFrameStats;
+
+		FrameBudgetStats lastFrameStats;
+
+		bool isFirstFrame = true;
+	};
+}
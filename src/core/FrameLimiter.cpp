@@ -0,0 +1,51 @@
+#include "FrameLimiter.h"
+#include <thread>
+
+namespace vmc
+{
+	FrameLimiter::FrameLimiter(float targetFps, float spinMs) :
+		spinDuration(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(spinMs))),
+		nextFrameTime(Clock::now())
+	{
+		setTargetFps(targetFps);
+	}
+
+	float FrameLimiter::wait()
+	{
+		if (targetFps <= 0.0f) {
+			return 0.0f;
+		}
+
+		auto start = Clock::now();
+
+		// A frame that overran by more than a whole period restarts the schedule rather than rushing to catch up.
+		nextFrameTime += framePeriod;
+		if (nextFrameTime + framePeriod < start) {
+			nextFrameTime = start;
+			return 0.0f;
+		}
+
+		auto sleepUntil = nextFrameTime - spinDuration;
+		if (start < sleepUntil) {
+			std::this_thread::sleep_until(sleepUntil);
+		}
+
+		while (Clock::now() < nextFrameTime) {
+			std::this_thread::yield();
+		}
+
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	void FrameLimiter::setTargetFps(float targetFps)
+	{
+		this->targetFps = targetFps;
+		framePeriod = targetFps > 0.0f ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.0f / targetFps)) : Clock::duration::zero();
+		nextFrameTime = Clock::now();
+	}
+
+	float FrameLimiter::getTargetFps() const
+	{
+		return targetFps;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace vmc
+{
+	// Sleeping is only accurate to the scheduler's tick, so the last stretch before the deadline is spun instead.
+	const float DefaultFrameLimiterSpinMs = 2.0f;
+
+	class FrameLimiter
+	{
+	public:
+		FrameLimiter(float targetFps = 0.0f, float spinMs = DefaultFrameLimiterSpinMs);
+
+		float wait();
+
+		void setTargetFps(float targetFps);
+
+		float getTargetFps() const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		float targetFps;
+
+		Clock::duration spinDuration;
+
+		Clock::duration framePeriod;
+
+		Clock::time_point nextFrameTime;
+	};
+}
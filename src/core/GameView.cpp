@@ -4,11 +4,46 @@
 #include <vk/ShaderModule.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <common/Log.h>
+#include <common/Profiler.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
 
 namespace vmc
 {
+	struct ChunkPushConstants
+	{
+		glm::ivec4 chunkOffset;
+	};
+
+	const char* ChunkRenderModeNames[] = { "direct", "parallel direct", "cached", "indirect", "gpu culled", "occlusion culled" };
+
+	static void appendOverlayLine(std::string& text, const char* format, ...)
+	{
+		char line[128];
+
+		va_list args;
+		va_start(args, format);
+		vsnprintf(line, sizeof(line), format, args);
+		va_end(args);
+
+		text += line;
+		text += '\n';
+	}
+
+	static uint32_t getOverlayFrameTimeColor(float frameTimeMs)
+	{
+		if (frameTimeMs > OverlayGraphMaxMs * 0.5f) {
+			return frameTimeMs > OverlayGraphMaxMs ? packOverlayColor(230, 60, 50) : packOverlayColor(240, 200, 40);
+		}
+
+		return packOverlayColor(80, 200, 80);
+	}
+
 	GameView::GameView(Application& application) :
 		View(application),
+        frameTimesMs(OverlayFrameTimeSamples, 0.0f),
         world(512)
 	{
         mainAtlasDescriptor = application.getTextureBundle().getDescriptor("main_atlas");
@@ -18,8 +53,15 @@ namespace vmc
 		initMeshes();
 		
 		camera.setPosition({ 0, 60.0f, 2.0f });
-		camera.addPitch(-3.141592 / 2);
-		lockCursor();
+		// Benchmark screenshots stay comparable between runs without the overlay, which F1 brings back in a window.
+		if (application.isHeadless()) {
+			camera.addPitch(HeadlessCameraPitch);
+			isOverlayVisible = false;
+		}
+		else {
+			camera.addPitch(-3.141592 / 2);
+			lockCursor();
+		}
 	}
 
 	GameView::~GameView()
@@ -28,10 +70,43 @@ namespace vmc
 
 	void GameView::update(float timeDelta)
 	{
-		auto& window = application.getWindow();
+		VMC_PROFILE_ZONE("update view");
+		// Headless runs have no input, so the camera turns by a fixed angle every frame and each run sees the same views.
+		if (application.isHeadless()) {
+			camera.addYaw(HeadlessCameraYawPerFrame);
+		}
+		else {
+			handleInput();
+			updateCamera();
+		}
 
-		uint32_t windowCenterX = window.getWidth() / 2;
-		uint32_t windowCenterY = window.getHeight() / 2;
+		activateUploadedMeshes();
+		unloadDistantChunks(camera.getPosition());
+		enqueueSurroundingChunks(camera.getPosition());
+
+		// All chunks loaded in a frame share one staging batch, so the batches in flight are not used up by a single frame.
+		auto& frameBudget = application.getFrameBudget();
+		if (!chunksToLoad.empty() && frameBudget.canStartTask()) {
+			auto& stagingManager = application.getStagingManager();
+			stagingManager.start();
+
+			uploadingChunks.clear();
+			while (!chunksToLoad.empty() && frameBudget.canStartTask()) {
+				uploadingChunks.push_back(chunksToLoad.front());
+				frameBudget.startTask();
+				frameBudget.finishTask(loadNextChunk(stagingManager));
+			}
+
+			auto uploadBatch = stagingManager.flush();
+			for (const auto& coord : uploadingChunks) {
+				pendingChunkMeshes.at(coord).uploadBatch = uploadBatch;
+			}
+		}
+	}
+
+	void GameView::handleInput()
+	{
+		auto& window = application.getWindow();
 
 		if (!isCursorLocked && window.isMouseButtonPressed(GLFW_MOUSE_BUTTON_1)) {
 			lockCursor();
@@ -41,6 +116,50 @@ namespace vmc
 			unlockCursor();
 		}
 
+		if (window.isKeyJustPressed(GLFW_KEY_F1)) {
+			isOverlayVisible = !isOverlayVisible;
+		}
+
+		if (window.isKeyJustPressed(GLFW_KEY_F2)) {
+			switchChunkRenderMode();
+		}
+
+		if (window.isKeyJustPressed(GLFW_KEY_F3)) {
+			isCaveCullingEnabled = !isCaveCullingEnabled;
+			logd("Cave culling: %s.", isCaveCullingEnabled ? "on" : "off");
+		}
+
+		if (window.isKeyJustPressed(GLFW_KEY_F4)) {
+			isSoftwareOcclusionEnabled = !isSoftwareOcclusionEnabled;
+			logd("Software occlusion culling: %s.", isSoftwareOcclusionEnabled ? "on" : "off");
+		}
+
+		if (window.isKeyJustPressed(GLFW_KEY_F5)) {
+			isOverdrawVisible = !isOverdrawVisible;
+			cachedChunkCommands->invalidate();
+			logd("Overdraw visualisation: %s.", isOverdrawVisible ? "on" : "off");
+		}
+
+		if (window.isKeyJustPressed(GLFW_KEY_F6)) {
+			isLateLatchEnabled = !isLateLatchEnabled;
+			logd("Late-latched camera: %s.", isLateLatchEnabled ? "on" : "off");
+		}
+	}
+
+	void GameView::updateCamera()
+	{
+		auto& window = application.getWindow();
+
+		uint32_t windowCenterX = window.getWidth() / 2;
+		uint32_t windowCenterY = window.getHeight() / 2;
+
+		// The camera runs on its own clock, since it is advanced both in update and again when latched just before
+		// submission. Long gaps such as a minimised window are capped so the camera does not jump.
+		auto now = std::chrono::steady_clock::now();
+		float cameraTimeDelta = std::min(std::chrono::duration<float>(now - lastCameraUpdateTime).count(), MaxCameraTimeDelta);
+		lastCameraUpdateTime = now;
+		inputSampleTime = now;
+
 		if (isCursorLocked) {
 			auto mousePos = window.getMousePos();
 
@@ -81,57 +200,721 @@ namespace vmc
 			speedUp *= 2;
         }
 
-		camera.moveForward(speedForward * 3.0f * timeDelta);
-		camera.moveSide(speedSide * 3.0f * timeDelta);
-		camera.moveUp(speedUp * 3.0f * timeDelta);
-
-		enqueueSurroundingChunks(camera.getPosition());
-		loadNextChunk();
+		camera.moveForward(speedForward * 3.0f * cameraTimeDelta);
+		camera.moveSide(speedSide * 3.0f * cameraTimeDelta);
+		camera.moveUp(speedUp * 3.0f * cameraTimeDelta);
 	}
 
 	void GameView::render(RenderContext& renderContext)
 	{
-		auto& uniform = renderContext.getMVPUniform();
-		auto uniformDescriptorSet = uniform.getDescriptorSet();
+		VMC_PROFILE_ZONE("render view");
+		recordFrameTime();
 
-		auto viewMatrix = camera.getViewMatrix();
-		auto projectionMatrix = glm::perspective(glm::radians(55.0f), (float)renderContext.getWidth() / renderContext.getHeight(), 0.01f, 1000.0f);
-		projectionMatrix[1][1] *= -1;
+		// The occlusion path builds its depth pyramid with the recorded view-projection, so it cannot be latched later.
+		bool isCameraLatched = isLateLatchEnabled && !application.isHeadless() && chunkRenderMode != ChunkRenderMode::OcclusionCulled;
 
-		auto commandBuffer = renderContext.startFrame({ 0.8f, 0.9f, 1.0f, 1.0f });
+		auto viewProjection = getViewProjection(renderContext, CameraFieldOfView);
 
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, defaultPipeline->getHandle());
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, defaultPipeline->getLayout(), 1, 1, &mainAtlasDescriptor, 0, nullptr);
+		// A latched camera may still turn a little after culling, so culling uses a wider field of view.
+		Frustum frustum(isCameraLatched ? getViewProjection(renderContext, CameraFieldOfView + LateLatchFieldOfViewMargin) : viewProjection);
 
-        for (const auto& entry : chunkMeshes) {
-            glm::vec3 chunkOffset(0, 0, 0);
-            chunkOffset.x = entry.first[0] * (int32_t)ChunkWidth;
-            chunkOffset.z = entry.first[1] * (int32_t)ChunkLength;
+		// Every path below keeps the order of the draw list, so opaque chunks reach the depth test front to back.
+		sortChunkDrawOrder();
 
-            const auto& mesh = entry.second;
+		chunkBounds.clear();
+		chunkDrawList.clear();
+		for (const auto& order : chunkDrawOrder) {
+			const auto& entry = *chunkMeshes.find(order.second);
+			glm::vec3 chunkOffset(entry.first[0] * (int32_t)ChunkWidth, 0, entry.first[1] * (int32_t)ChunkLength);
+			chunkBounds.add(chunkOffset + entry.second.getBoundsMin(), chunkOffset + entry.second.getBoundsMax());
+			chunkDrawList.push_back(&entry);
+		}
+		if (isCaveCullingEnabled) {
+			VMC_PROFILE_ZONE("cave culling");
+			caveCuller.update(camera.getPosition(), frustum, chunkConnectivity);
+		}
 
-            auto modelMatrix = glm::translate(glm::mat4(1.0f), chunkOffset);
-            auto mvp = projectionMatrix * viewMatrix * modelMatrix;
+		renderStats = RenderStats();
 
-            uint32_t uniformOffset = uniform.pushData(&mvp);
-            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, defaultPipeline->getLayout(), 0, 1, &uniformDescriptorSet, 1, &uniformOffset);
+		bool isCulledOnGpu = chunkRenderMode == ChunkRenderMode::GpuCulled || chunkRenderMode == ChunkRenderMode::OcclusionCulled;
+		if (!isCulledOnGpu) {
+			VMC_PROFILE_ZONE("cull chunks");
+			chunkBounds.cull(frustum, chunkVisibility);
 
-            VkBuffer vertexBufferHandle = mesh.getVertexBuffer().getHandle();
-            VkDeviceSize offset = 0;
-            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBufferHandle, &offset);
+			for (size_t i = 0; i < chunkDrawList.size(); i++) {
+				if (chunkVisibility[i] && isHiddenByTerrain(chunkDrawList[i]->first)) {
+					chunkVisibility[i] = 0;
+					renderStats.caveCulledDraws++;
+				}
+			}
 
-            vkCmdBindIndexBuffer(commandBuffer, mesh.getIndexBuffer().getHandle(), 0, VK_INDEX_TYPE_UINT32);
+			if (isSoftwareOcclusionEnabled) {
+				rasterizeOccluders(viewProjection, frustum);
 
-            vkCmdDrawIndexed(commandBuffer, mesh.getIndicesCount(), 1, 0, 0, 0);
-        }
+				for (size_t i = 0; i < chunkDrawList.size(); i++) {
+					if (chunkVisibility[i] && isHiddenByOccluders(chunkDrawList[i]->first, chunkDrawList[i]->second)) {
+						chunkVisibility[i] = 0;
+						renderStats.occlusionCulledDraws++;
+					}
+				}
+			}
+		}
+
+		// Occlusion culling rebuilds the depth pyramid between its two draw passes, which has to happen outside the render pass.
+		auto renderPassMode = chunkRenderMode == ChunkRenderMode::OcclusionCulled ? RenderPassMode::Split : RenderPassMode::Single;
+		VkClearColorValue clearColor = isOverdrawVisible ? VkClearColorValue{ 0.0f, 0.0f, 0.0f, 1.0f } : VkClearColorValue{ 0.8f, 0.9f, 1.0f, 1.0f };
+		bool isRecordedInSecondaries = chunkRenderMode == ChunkRenderMode::ParallelDirect || chunkRenderMode == ChunkRenderMode::Cached;
+		auto subpassContents = isRecordedInSecondaries ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+		auto commandBuffer = renderContext.startFrame(clearColor, renderPassMode, subpassContents);
+		if (commandBuffer == VK_NULL_HANDLE) {
+			return;
+		}
+
+		// Every draw reads the view-projection from this one allocation, so it can still be rewritten until submission.
+		auto viewProjectionUniform = renderContext.getUniformAllocator().push(viewProjection);
+
+		if (chunkRenderMode == ChunkRenderMode::OcclusionCulled) {
+			recordOcclusionCulledChunkDraws(renderContext, commandBuffer, viewProjection, viewProjectionUniform, frustum);
+		}
+		else if (chunkRenderMode == ChunkRenderMode::GpuCulled) {
+			recordGpuCulledChunkDraws(renderContext, commandBuffer, viewProjectionUniform, frustum);
+		}
+		else if (chunkRenderMode == ChunkRenderMode::Indirect) {
+			recordIndirectChunkDraws(renderContext, commandBuffer, viewProjectionUniform);
+		}
+		else if (chunkRenderMode == ChunkRenderMode::ParallelDirect) {
+			recordParallelChunkDraws(renderContext, viewProjectionUniform);
+		}
+		else if (chunkRenderMode == ChunkRenderMode::Cached) {
+			recordCachedChunkDraws(renderContext, viewProjection);
+		}
+		else {
+			recordDirectChunkDraws(renderContext, commandBuffer, viewProjectionUniform);
+		}
+
+		if (isOverlayVisible && overlay) {
+			recordOverlay(renderContext, commandBuffer);
+		}
+
+		if (isCameraLatched) {
+			latchCamera(renderContext, viewProjectionUniform);
+		}
 
 		renderContext.endFrame();
+
+		if (!application.isHeadless()) {
+			renderStats.inputLatencyMs = std::chrono::duration<float, std::milli>(renderContext.getLastSubmitTime() - inputSampleTime).count();
+		}
+	}
+
+	glm::mat4 GameView::getViewProjection(const RenderContext& renderContext, float fieldOfView)
+	{
+		auto projectionMatrix = glm::perspective(glm::radians(fieldOfView), (float)renderContext.getWidth() / renderContext.getHeight(), 0.01f, 1000.0f);
+		projectionMatrix[1][1] *= -1;
+
+		return projectionMatrix * camera.getViewMatrix();
+	}
+
+	void GameView::latchCamera(RenderContext& renderContext, const UniformAllocation& viewProjectionUniform)
+	{
+		// Recording is done, so the freshest input is sampled and only the view-projection the draws read is rewritten.
+		application.getWindow().pollInputEvents();
+		updateCamera();
+
+		auto viewProjection = getViewProjection(renderContext, CameraFieldOfView);
+		memcpy(viewProjectionUniform.data, &viewProjection, sizeof(viewProjection));
+
+		if (chunkRenderMode == ChunkRenderMode::Cached) {
+			cachedChunkCommands->setUniform(renderContext, viewProjection);
+		}
+	}
+
+	void GameView::recordDirectChunkDraws(RenderContext& renderContext, VkCommandBuffer commandBuffer, const UniformAllocation& viewProjectionUniform)
+	{
+		VMC_PROFILE_ZONE("record chunk draws");
+		for (size_t i = 0; i < chunkDrawList.size(); i++) {
+			if (chunkVisibility[i]) {
+				renderStats.visibleDraws++;
+			}
+			else {
+				renderStats.culledDraws++;
+			}
+		}
+
+		// All opaque geometry goes first, so the alpha-tested pass only shades fragments in front of the finished opaque depth.
+		for (uint32_t part = 0; part < MeshPartCount; part++) {
+			const auto& pipeline = getDirectChunkPipeline((MeshPart)part);
+			bindChunkPipeline(commandBuffer, pipeline, viewProjectionUniform);
+
+			for (size_t i = 0; i < chunkDrawList.size(); i++) {
+				if (chunkVisibility[i] && recordDirectChunkDraw(commandBuffer, pipeline, (MeshPart)part, *chunkDrawList[i])) {
+					renderStats.drawCalls++;
+				}
+			}
+		}
+
+		renderStats.recordedDraws = renderStats.drawCalls;
+	}
+
+	bool GameView::recordDirectChunkDraw(VkCommandBuffer commandBuffer, const RenderPipeline& pipeline, MeshPart part, const std::pair<const glm::ivec2, Mesh>& entry)
+	{
+		const auto& mesh = entry.second;
+		if (mesh.getIndicesCount(part) == 0) {
+			return false;
+		}
+
+		// The view-projection is bound once per frame, each chunk only supplies its integer block offset.
+		ChunkPushConstants pushConstants;
+		pushConstants.chunkOffset = glm::ivec4(entry.first[0] * (int32_t)ChunkWidth, 0, entry.first[1] * (int32_t)ChunkLength, 0);
+		vkCmdPushConstants(commandBuffer, pipeline.getLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ChunkPushConstants), &pushConstants);
+
+		VkBuffer vertexBufferHandle = mesh.getVertexBuffer().getHandle();
+		VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBufferHandle, &offset);
+
+		vkCmdBindIndexBuffer(commandBuffer, mesh.getIndexBuffer().getHandle(), 0, VK_INDEX_TYPE_UINT32);
+
+		vkCmdDrawIndexed(commandBuffer, mesh.getIndicesCount(part), 1, mesh.getFirstIndex(part), mesh.getVertexOffset(), 0);
+		return true;
+	}
+
+	void GameView::recordParallelChunkDraws(RenderContext& renderContext, const UniformAllocation& viewProjectionUniform)
+	{
+		VMC_PROFILE_ZONE("record chunk draws");
+		// The uniform allocator is not thread-safe, so the workers only share allocations made up front.
+		visibleChunkIndices.clear();
+		for (size_t i = 0; i < chunkDrawList.size(); i++) {
+			if (chunkVisibility[i]) {
+				visibleChunkIndices.push_back((uint32_t)i);
+			}
+		}
+		renderStats.visibleDraws = (uint32_t)visibleChunkIndices.size();
+		renderStats.culledDraws = (uint32_t)chunkDrawList.size() - renderStats.visibleDraws;
+
+		// Every worker records a contiguous slice of the front to back list for each mesh part. Executing all opaque slices
+		// before all cutout slices, in worker order, reproduces the order of the single-threaded path.
+		uint32_t workerCount = std::max(std::min(renderContext.getWorkerCount(), (uint32_t)visibleChunkIndices.size()), 1u);
+		secondaryCommandBuffers.assign(workerCount * MeshPartCount, VK_NULL_HANDLE);
+		workerDrawCalls.assign(workerCount, 0);
+
+		application.getThreadPool().run(workerCount, [&](uint32_t worker) {
+			size_t begin = visibleChunkIndices.size() * worker / workerCount;
+			size_t end = visibleChunkIndices.size() * (worker + 1) / workerCount;
+
+			for (uint32_t part = 0; part < MeshPartCount; part++) {
+				auto commandBuffer = renderContext.beginSecondaryCommandBuffer(worker);
+				const auto& pipeline = getDirectChunkPipeline((MeshPart)part);
+				bindChunkPipeline(commandBuffer, pipeline, viewProjectionUniform);
+
+				for (size_t i = begin; i < end; i++) {
+					if (recordDirectChunkDraw(commandBuffer, pipeline, (MeshPart)part, *chunkDrawList[visibleChunkIndices[i]])) {
+						workerDrawCalls[worker]++;
+					}
+				}
+
+				renderContext.endSecondaryCommandBuffer(commandBuffer);
+				secondaryCommandBuffers[part * workerCount + worker] = commandBuffer;
+			}
+		});
+
+		renderContext.executeSecondaryCommandBuffers(secondaryCommandBuffers);
+		for (auto drawCalls : workerDrawCalls) {
+			renderStats.drawCalls += drawCalls;
+		}
+		renderStats.recordedDraws = renderStats.drawCalls;
+	}
+
+	void GameView::recordCachedChunkDraws(RenderContext& renderContext, const glm::mat4& viewProjection)
+	{
+		VMC_PROFILE_ZONE("record chunk draws");
+		// The recorded commands read the view-projection from a slot at a fixed address, so camera motion alone only
+		// rewrites the slot.
+		cachedChunkCommands->setUniform(renderContext, viewProjection);
+
+		visibleChunkCoords.clear();
+		for (size_t i = 0; i < chunkDrawList.size(); i++) {
+			if (chunkVisibility[i]) {
+				visibleChunkCoords.push_back(chunkDrawList[i]->first);
+			}
+		}
+		renderStats.visibleDraws = (uint32_t)visibleChunkCoords.size();
+		renderStats.culledDraws = (uint32_t)chunkDrawList.size() - renderStats.visibleDraws;
+
+		// Mesh changes invalidate the commands where they happen, the visible set and its order are compared here.
+		if (visibleChunkCoords != cachedVisibleChunkCoords) {
+			cachedVisibleChunkCoords = visibleChunkCoords;
+			cachedChunkCommands->invalidate();
+		}
+
+		if (!cachedChunkCommands->isValid(renderContext)) {
+			auto commandBuffer = cachedChunkCommands->beginRecording(renderContext);
+			auto viewProjectionUniform = cachedChunkCommands->getUniform(renderContext);
+			cachedChunkDrawCalls = 0;
+
+			for (uint32_t part = 0; part < MeshPartCount; part++) {
+				const auto& pipeline = getDirectChunkPipeline((MeshPart)part);
+				bindChunkPipeline(commandBuffer, pipeline, viewProjectionUniform);
+
+				for (size_t i = 0; i < chunkDrawList.size(); i++) {
+					if (chunkVisibility[i] && recordDirectChunkDraw(commandBuffer, pipeline, (MeshPart)part, *chunkDrawList[i])) {
+						cachedChunkDrawCalls++;
+					}
+				}
+			}
+
+			cachedChunkCommands->endRecording(renderContext);
+			renderStats.recordedDraws = cachedChunkDrawCalls;
+		}
+
+		cachedChunkCommands->execute(renderContext);
+		renderStats.drawCalls = cachedChunkDrawCalls;
+	}
+
+	void GameView::recordIndirectChunkDraws(RenderContext& renderContext, VkCommandBuffer commandBuffer, const UniformAllocation& viewProjectionUniform)
+	{
+		VMC_PROFILE_ZONE("record chunk draws");
+		auto& drawBuffer = getIndirectDrawBuffer(renderContext);
+		auto& meshPool = application.getMeshPool();
+		drawBuffer.reset();
+
+		// Draws are grouped by mesh part and then by mesh pool page, since every draw of one indirect call shares the bound
+		// pipeline and the bound vertex and index buffers.
+		uint32_t pageCount = meshPool.getPageCount();
+		pageDrawRanges.assign(pageCount * MeshPartCount, { 0, 0 });
+		for (uint32_t part = 0; part < MeshPartCount; part++) {
+			for (uint32_t page = 0; page < pageCount; page++) {
+				auto& range = pageDrawRanges[part * pageCount + page];
+				range.first = drawBuffer.getDrawCount();
+
+				for (size_t i = 0; i < chunkDrawList.size(); i++) {
+					const auto& mesh = chunkDrawList[i]->second;
+					if (!chunkVisibility[i] || mesh.getPage() != page || mesh.getIndicesCount((MeshPart)part) == 0) {
+						continue;
+					}
+
+					const auto& coord = chunkDrawList[i]->first;
+					glm::vec4 chunkOffset(coord[0] * (int32_t)ChunkWidth, 0, coord[1] * (int32_t)ChunkLength, 0);
+					drawBuffer.add(mesh.getIndicesCount((MeshPart)part), mesh.getFirstIndex((MeshPart)part), mesh.getVertexOffset(), chunkOffset);
+				}
+
+				range.second = drawBuffer.getDrawCount() - range.first;
+			}
+		}
+
+		drawBuffer.flush();
+
+		for (size_t i = 0; i < chunkDrawList.size(); i++) {
+			if (chunkVisibility[i] && chunkDrawList[i]->second.getIndicesCount() > 0) {
+				renderStats.visibleDraws++;
+			}
+		}
+		renderStats.culledDraws = (uint32_t)chunkDrawList.size() - renderStats.visibleDraws;
+
+		const auto& features = application.getDevice().getEnabledFeatures();
+		VkDeviceSize commandStride = sizeof(VkDrawIndexedIndirectCommand);
+
+		for (uint32_t part = 0; part < MeshPartCount; part++) {
+			bindChunkPipeline(commandBuffer, getIndirectChunkPipeline((MeshPart)part), viewProjectionUniform);
+
+			for (uint32_t page = 0; page < pageCount; page++) {
+				uint32_t firstDraw = pageDrawRanges[part * pageCount + page].first;
+				uint32_t drawCount = pageDrawRanges[part * pageCount + page].second;
+				if (drawCount == 0) {
+					continue;
+				}
+
+				VkBuffer vertexBuffers[] = { meshPool.getVertexBuffer(page).getHandle(), drawBuffer.getInstanceBuffer().getHandle() };
+				VkDeviceSize offsets[] = { 0, 0 };
+				vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+				vkCmdBindIndexBuffer(commandBuffer, meshPool.getIndexBuffer(page).getHandle(), 0, VK_INDEX_TYPE_UINT32);
+
+				auto indirectBuffer = drawBuffer.getCommandBuffer().getHandle();
+				if (features.multiDrawIndirect && features.drawIndirectFirstInstance) {
+					vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, firstDraw * commandStride, drawCount, (uint32_t)commandStride);
+					renderStats.drawCalls++;
+				}
+				else if (features.drawIndirectFirstInstance) {
+					for (uint32_t i = firstDraw; i < firstDraw + drawCount; i++) {
+						vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, i * commandStride, 1, (uint32_t)commandStride);
+						renderStats.drawCalls++;
+					}
+				}
+				else {
+					for (uint32_t i = firstDraw; i < firstDraw + drawCount; i++) {
+						const auto& command = drawBuffer.getCommand(i);
+						vkCmdDrawIndexed(commandBuffer, command.indexCount, 1, command.firstIndex, command.vertexOffset, command.firstInstance);
+						renderStats.drawCalls++;
+					}
+				}
+			}
+		}
+	}
+
+	void GameView::recordGpuCulledChunkDraws(RenderContext& renderContext, VkCommandBuffer commandBuffer, const UniformAllocation& viewProjectionUniform, const Frustum& frustum)
+	{
+		VMC_PROFILE_ZONE("record chunk draws");
+		auto& meshPool = application.getMeshPool();
+		addGpuCullRecords();
+
+		// The cull runs on the compute queue ahead of this frame's graphics submission, which waits for it before reading the draws.
+		gpuChunkCuller->dispatch(renderContext, frustum, meshPool.getPageCount());
+
+		for (uint32_t part = 0; part < MeshPartCount; part++) {
+			bindChunkPipeline(commandBuffer, getIndirectChunkPipeline((MeshPart)part), viewProjectionUniform);
+			gpuChunkCuller->draw(commandBuffer, meshPool, renderStats, (MeshPart)part);
+		}
+		updateGpuCullStats();
+	}
+
+	void GameView::recordOcclusionCulledChunkDraws(RenderContext& renderContext, VkCommandBuffer commandBuffer, const glm::mat4& viewProjection, const UniformAllocation& viewProjectionUniform, const Frustum& frustum)
+	{
+		VMC_PROFILE_ZONE("record chunk draws");
+		auto& meshPool = application.getMeshPool();
+		addGpuCullRecords();
+
+		// The first pass tests against the pyramid of the previous frame, reprojected with the view it was built from.
+		depthPyramid->prepare(renderContext, commandBuffer);
+		gpuChunkCuller->recordOcclusionFirstPass(renderContext, commandBuffer, frustum, *depthPyramid, meshPool.getPageCount());
+
+		for (uint32_t pass = 0; pass < GpuCullPassCount; pass++) {
+			if (pass > 0) {
+				renderContext.suspendRenderPass();
+				depthPyramid->build(renderContext, commandBuffer, viewProjection);
+				gpuChunkCuller->recordOcclusionSecondPass(renderContext, commandBuffer, frustum, viewProjection, *depthPyramid);
+				renderContext.resumeRenderPass();
+			}
+			else {
+				renderContext.beginRenderPass();
+			}
+
+			for (uint32_t part = 0; part < MeshPartCount; part++) {
+				bindChunkPipeline(commandBuffer, getIndirectChunkPipeline((MeshPart)part), viewProjectionUniform);
+				gpuChunkCuller->draw(commandBuffer, meshPool, renderStats, (MeshPart)part, pass);
+			}
+		}
+
+		updateGpuCullStats();
+	}
+
+	void GameView::recordFrameTime()
+	{
+		// Frame times are measured between renders, so they include everything the application does in between.
+		auto now = std::chrono::steady_clock::now();
+		if (lastRenderTime != std::chrono::steady_clock::time_point()) {
+			frameTimesMs[frameTimeIndex] = std::chrono::duration<float, std::milli>(now - lastRenderTime).count();
+			frameTimeIndex = (frameTimeIndex + 1) % OverlayFrameTimeSamples;
+		}
+		lastRenderTime = now;
+	}
+
+	void GameView::recordOverlay(RenderContext& renderContext, VkCommandBuffer commandBuffer)
+	{
+		VMC_PROFILE_ZONE("record overlay");
+		float frameTimeSumMs = 0.0f;
+		float maxFrameTimeMs = 0.0f;
+		uint32_t frameTimeCount = 0;
+		for (auto frameTimeMs : frameTimesMs) {
+			if (frameTimeMs > 0.0f) {
+				frameTimeSumMs += frameTimeMs;
+				maxFrameTimeMs = std::max(maxFrameTimeMs, frameTimeMs);
+				frameTimeCount++;
+			}
+		}
+
+		const float bytesInKilobyte = 1024.0f;
+		const float bytesInMegabyte = 1024.0f * 1024.0f;
+		auto meshPoolStats = application.getMeshPool().getStats();
+		const auto& stagingStats = application.getStagingManager().getStats();
+
+		overlayText.clear();
+		appendOverlayLine(overlayText, "FPS %u  FRAME %.2f MS  MAX %.2f MS", application.getFPS(), frameTimeCount > 0 ? frameTimeSumMs / frameTimeCount : 0.0f, maxFrameTimeMs);
+		appendOverlayLine(overlayText, "MODE %s", ChunkRenderModeNames[(uint32_t)chunkRenderMode]);
+		appendOverlayLine(overlayText, "CHUNKS QUEUED %zu  GENERATED %zu", chunksToLoad.size(), world.getChunks().size());
+		appendOverlayLine(overlayText, "MESHES UPLOADING %zu  RESIDENT %zu", pendingChunkMeshes.size(), chunkMeshes.size());
+		appendOverlayLine(overlayText, "DRAWS %u  CALLS %u  RECORDED %u", renderStats.visibleDraws, renderStats.drawCalls, renderStats.recordedDraws);
+		appendOverlayLine(overlayText, "CULLED %u  CAVE %u  OCCLUSION %u", renderStats.culledDraws, renderStats.caveCulledDraws, renderStats.occlusionCulledDraws);
+		appendOverlayLine(overlayText, "VERTICES %u  INDICES %u", meshPoolStats.vertexCount, meshPoolStats.indexCount);
+		appendOverlayLine(overlayText, "MESH MEMORY %.1f OF %.1f MB", meshPoolStats.usedBytes / bytesInMegabyte, meshPoolStats.allocatedBytes / bytesInMegabyte);
+		appendOverlayLine(overlayText, "STAGING MEMORY %.1f MB  STALLS %u", stagingStats.allocatedBytes / bytesInMegabyte, stagingStats.stallsLastFrame);
+		appendOverlayLine(overlayText, "UPLOAD %.1f KB PER FRAME", stagingStats.bytesStagedLastFrame / bytesInKilobyte);
+		if (!application.isHeadless()) {
+			appendOverlayLine(overlayText, "INPUT LATENCY %.2f MS", renderStats.inputLatencyMs);
+		}
+		for (const auto& timing : renderContext.getGpuProfiler().getTimings()) {
+			appendOverlayLine(overlayText, "GPU %s %.2f MS", timing.name, timing.averageMs);
+		}
+		for (const auto& timing : application.getStagingManager().getGpuTimings()) {
+			appendOverlayLine(overlayText, "GPU %s %.2f MS", timing.name, timing.averageMs);
+		}
+
+		size_t lineCount = 0;
+		size_t maxLineLength = 0;
+		size_t lineStart = 0;
+		for (size_t i = 0; i < overlayText.size(); i++) {
+			if (overlayText[i] == '\n') {
+				maxLineLength = std::max(maxLineLength, i - lineStart);
+				lineStart = i + 1;
+				lineCount++;
+			}
+		}
+
+		// The panel is laid out before any text is added, since quads are drawn in the order they are added.
+		const float margin = 8.0f;
+		const float padding = 6.0f;
+		float lineHeight = overlay->getLineHeight();
+		float graphWidth = OverlayFrameTimeSamples * 2.0f;
+		float textWidth = overlay->getTextWidth(maxLineLength);
+		float panelWidth = std::max(textWidth, graphWidth) + padding * 2.0f;
+		float panelHeight = lineCount * lineHeight + OverlayGraphHeight + padding * 3.0f;
+
+		overlay->begin(renderContext);
+		overlay->addRectangle(margin, margin, panelWidth, panelHeight, packOverlayColor(0, 0, 0, 160));
+		overlay->addText(margin + padding, margin + padding, overlayText.c_str(), packOverlayColor(255, 255, 255));
+
+		// Bars run from the oldest sample on the left to the newest on the right, with a line at the 60 fps budget.
+		float graphX = margin + padding;
+		float graphBottom = margin + padding * 2.0f + lineCount * lineHeight + OverlayGraphHeight;
+		float barWidth = graphWidth / OverlayFrameTimeSamples;
+		for (uint32_t i = 0; i < OverlayFrameTimeSamples; i++) {
+			float frameTimeMs = frameTimesMs[(frameTimeIndex + i) % OverlayFrameTimeSamples];
+			float barHeight = std::min(frameTimeMs / OverlayGraphMaxMs, 1.0f) * OverlayGraphHeight;
+			if (barHeight > 0.0f) {
+				overlay->addRectangle(graphX + i * barWidth, graphBottom - barHeight, barWidth, barHeight, getOverlayFrameTimeColor(frameTimeMs));
+			}
+		}
+		overlay->addRectangle(graphX, graphBottom - OverlayGraphHeight * 0.5f, graphWidth, 1.0f, packOverlayColor(255, 255, 255, 128));
+
+		overlay->record(renderContext, commandBuffer);
+	}
+
+	void GameView::addGpuCullRecords()
+	{
+		gpuChunkCuller->reset();
+		for (const auto* entry : chunkDrawList) {
+			const auto& mesh = entry->second;
+			if (mesh.getIndicesCount() == 0) {
+				continue;
+			}
+
+			if (isHiddenByTerrain(entry->first)) {
+				renderStats.caveCulledDraws++;
+				continue;
+			}
+
+			glm::vec3 chunkOffset(entry->first[0] * (int32_t)ChunkWidth, 0, entry->first[1] * (int32_t)ChunkLength);
+			for (uint32_t part = 0; part < MeshPartCount; part++) {
+				if (mesh.getIndicesCount((MeshPart)part) > 0) {
+					gpuChunkCuller->add(chunkOffset + mesh.getBoundsMin(), chunkOffset + mesh.getBoundsMax(), chunkOffset, mesh.getIndicesCount((MeshPart)part), mesh.getFirstIndex((MeshPart)part), mesh.getVertexOffset(), mesh.getPage(), (MeshPart)part);
+				}
+			}
+		}
+	}
+
+	void GameView::updateGpuCullStats()
+	{
+		// Visibility is only known on the GPU, so the statistics come from the read-back counts of an earlier frame.
+		uint32_t recordCount = gpuChunkCuller->getRecordCount();
+		renderStats.visibleDraws = std::min(gpuChunkCuller->getLastVisibleCount(), recordCount);
+		renderStats.culledDraws = recordCount - renderStats.visibleDraws + renderStats.caveCulledDraws;
+	}
+
+	const RenderPipeline& GameView::getDirectChunkPipeline(MeshPart part) const
+	{
+		return isOverdrawVisible ? *overdrawDirectPipelines[(uint32_t)part] : *directPipelines[(uint32_t)part];
+	}
+
+	const RenderPipeline& GameView::getIndirectChunkPipeline(MeshPart part) const
+	{
+		return isOverdrawVisible ? *overdrawIndirectPipelines[(uint32_t)part] : *indirectPipelines[(uint32_t)part];
+	}
+
+	void GameView::bindChunkPipeline(VkCommandBuffer commandBuffer, const RenderPipeline& pipeline, const UniformAllocation& viewProjectionUniform)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getHandle());
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), 0, 1, &viewProjectionUniform.descriptorSet, 1, &viewProjectionUniform.offset);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), 1, 1, &mainAtlasDescriptor, 0, nullptr);
+	}
+
+	void GameView::sortChunkDrawOrder()
+	{
+		VMC_PROFILE_ZONE("sort chunks");
+		auto cameraPosition = camera.getPosition();
+		for (auto& order : chunkDrawOrder) {
+			const auto& mesh = chunkMeshes.find(order.second)->second;
+			glm::vec3 chunkOffset(order.second[0] * (int32_t)ChunkWidth, 0, order.second[1] * (int32_t)ChunkLength);
+			glm::vec3 closestPoint = glm::clamp(cameraPosition, chunkOffset + mesh.getBoundsMin(), chunkOffset + mesh.getBoundsMax());
+			glm::vec3 offset = closestPoint - cameraPosition;
+			order.first = glm::dot(offset, offset);
+		}
+
+		// The camera moves little between frames, so the previous order is nearly sorted and insertion sort stays close to linear.
+		for (size_t i = 1; i < chunkDrawOrder.size(); i++) {
+			auto order = chunkDrawOrder[i];
+			size_t j = i;
+			while (j > 0 && chunkDrawOrder[j - 1].first > order.first) {
+				chunkDrawOrder[j] = chunkDrawOrder[j - 1];
+				j--;
+			}
+			chunkDrawOrder[j] = order;
+		}
+	}
+
+	bool GameView::isHiddenByTerrain(const glm::ivec2& coord) const
+	{
+		return isCaveCullingEnabled && !caveCuller.isChunkVisible(coord);
+	}
+
+	void GameView::rasterizeOccluders(const glm::mat4& viewProjection, const Frustum& frustum)
+	{
+		VMC_PROFILE_ZONE("rasterize occluders");
+		occlusionRasterizer.clear(viewProjection, camera.getPosition());
+
+		// Only nearby terrain covers enough of the screen to hide anything, distant slabs would only cost rasterisation time.
+		auto cameraPosition = camera.getPosition();
+		glm::ivec2 cameraChunk((int32_t)std::floor(cameraPosition.x / ChunkWidth), (int32_t)std::floor(cameraPosition.z / ChunkLength));
+
+		for (const auto& entry : chunkOccluders) {
+			auto distance = glm::abs(entry.first - cameraChunk);
+			if ((uint32_t)std::max(distance.x, distance.y) > occluderChunkRadius) {
+				continue;
+			}
+
+			glm::vec3 chunkOffset(entry.first[0] * (int32_t)ChunkWidth, 0, entry.first[1] * (int32_t)ChunkLength);
+			if (!frustum.isBoxVisible(chunkOffset, chunkOffset + glm::vec3(ChunkWidth, ChunkHeight, ChunkLength))) {
+				continue;
+			}
+
+			occlusionRasterizer.addChunkOccluder(entry.first, entry.second);
+		}
+	}
+
+	bool GameView::isHiddenByOccluders(const glm::ivec2& coord, const Mesh& mesh)
+	{
+		glm::vec3 chunkOffset(coord[0] * (int32_t)ChunkWidth, 0, coord[1] * (int32_t)ChunkLength);
+		glm::vec3 boundsMin = chunkOffset + mesh.getBoundsMin();
+		glm::vec3 boundsMax = chunkOffset + mesh.getBoundsMax();
+
+		if (!occlusionRasterizer.isBoxVisible(boundsMin, boundsMax)) {
+			return true;
+		}
+
+		// A tall chunk can poke out of the occluders as a whole while each of its sections is still hidden.
+		uint32_t firstSection = (uint32_t)std::max(boundsMin.y, 0.0f) / SectionSize;
+		uint32_t lastSection = std::min((uint32_t)std::max(boundsMax.y - 1.0f, 0.0f) / SectionSize, SectionsPerChunk - 1);
+		if (firstSection == lastSection) {
+			return false;
+		}
+
+		for (uint32_t section = firstSection; section <= lastSection; section++) {
+			glm::vec3 sectionMin(boundsMin.x, std::max(boundsMin.y, (float)(section * SectionSize)), boundsMin.z);
+			glm::vec3 sectionMax(boundsMax.x, std::min(boundsMax.y, (float)((section + 1) * SectionSize)), boundsMax.z);
+			if (occlusionRasterizer.isBoxVisible(sectionMin, sectionMax)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void GameView::switchChunkRenderMode()
+	{
+		switch (chunkRenderMode) {
+		case ChunkRenderMode::Indirect:
+			chunkRenderMode = ChunkRenderMode::Direct;
+			break;
+		case ChunkRenderMode::Direct:
+			chunkRenderMode = ChunkRenderMode::ParallelDirect;
+			break;
+		case ChunkRenderMode::ParallelDirect:
+			chunkRenderMode = ChunkRenderMode::Cached;
+			break;
+		case ChunkRenderMode::Cached:
+			chunkRenderMode = gpuChunkCuller ? ChunkRenderMode::GpuCulled : ChunkRenderMode::Indirect;
+			break;
+		case ChunkRenderMode::GpuCulled:
+			chunkRenderMode = depthPyramid ? ChunkRenderMode::OcclusionCulled : ChunkRenderMode::Indirect;
+			break;
+		case ChunkRenderMode::OcclusionCulled:
+			chunkRenderMode = ChunkRenderMode::Indirect;
+			break;
+		}
+
+		logd("Chunk render mode: %s.", ChunkRenderModeNames[(uint32_t)chunkRenderMode]);
+	}
+
+	IndirectDrawBuffer& GameView::getIndirectDrawBuffer(RenderContext& renderContext)
+	{
+		if (indirectDrawBuffers.size() != renderContext.getFrameResourceCount()) {
+			indirectDrawBuffers.resize(renderContext.getFrameResourceCount());
+		}
+
+		auto& drawBuffer = indirectDrawBuffers[renderContext.getFrameResourceIndex()];
+		if (!drawBuffer) {
+			drawBuffer = std::make_unique<IndirectDrawBuffer>(application.getDevice());
+		}
+
+		return *drawBuffer;
+	}
+
+	const RenderStats& GameView::getRenderStats() const
+	{
+		return renderStats;
 	}
 
 	void GameView::initPipeline()
 	{
-		auto vertexShaderData = readBinaryFile("data/shaders/default.vert.spv");
-		auto fragmentShaderData = readBinaryFile("data/shaders/default.frag.spv");
+		auto startTime = std::chrono::high_resolution_clock::now();
+		auto pipelineCache = application.getPipelineCache().getHandle();
+
+		// The pipelines are independent of each other, so they are compiled concurrently. Every task only writes its own
+		// member, and the pipeline cache is internally synchronised.
+		const char* fragmentShaderPaths[MeshPartCount] = { "data/shaders/opaque.frag.spv", "data/shaders/default.frag.spv" };
+		const uint32_t chunkPipelineVariants = 4;
+		application.getThreadPool().run(chunkPipelineVariants * MeshPartCount + 2, [&](uint32_t task) {
+			if (task == chunkPipelineVariants * MeshPartCount + 1) {
+				const auto& textureBundle = application.getTextureBundle();
+				overlay = std::make_unique<OverlayRenderer>(application.getDevice(), application.getRenderPass(), application.getTextureLayout(), textureBundle.getDescriptor("font"), pipelineCache);
+				return;
+			}
+
+			if (task == chunkPipelineVariants * MeshPartCount) {
+				if (GpuChunkCuller::isSupported(application.getDevice())) {
+					gpuChunkCuller = std::make_unique<GpuChunkCuller>(application.getDevice(), application.getMVPLayout(), pipelineCache);
+
+					if (gpuChunkCuller->isOcclusionSupported()) {
+						depthPyramid = std::make_unique<DepthPyramid>(application.getDevice(), pipelineCache);
+					}
+				}
+				return;
+			}
+
+			auto part = (MeshPart)(task % MeshPartCount);
+			switch (task / MeshPartCount) {
+			case 0:
+				directPipelines[(uint32_t)part] = createChunkPipeline("data/shaders/default.vert.spv", fragmentShaderPaths[(uint32_t)part], false, part, false);
+				break;
+			case 1:
+				indirectPipelines[(uint32_t)part] = createChunkPipeline("data/shaders/chunk_indirect.vert.spv", fragmentShaderPaths[(uint32_t)part], true, part, false);
+				break;
+			case 2:
+				overdrawDirectPipelines[(uint32_t)part] = createChunkPipeline("data/shaders/default.vert.spv", "data/shaders/overdraw.frag.spv", false, part, true);
+				break;
+			case 3:
+				overdrawIndirectPipelines[(uint32_t)part] = createChunkPipeline("data/shaders/chunk_indirect.vert.spv", "data/shaders/overdraw.frag.spv", true, part, true);
+				break;
+			}
+		});
+
+		auto elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		logd("Created pipelines in %.1f ms.", elapsedMs);
+
+		cachedChunkCommands = std::make_unique<CachedCommandBuffer>(application.getDevice(), application.getMVPLayout());
+	}
+
+	std::unique_ptr<RenderPipeline> GameView::createChunkPipeline(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, bool hasChunkOffsetAttribute, MeshPart part, bool isOverdrawPipeline)
+	{
+		auto vertexShaderData = readBinaryFile(vertexShaderPath);
+		auto fragmentShaderData = readBinaryFile(fragmentShaderPath);
 
 		VulkanShaderModule vertexShader(application.getDevice(), vertexShaderData, VK_SHADER_STAGE_VERTEX_BIT);
 		VulkanShaderModule fragmentShader(application.getDevice(), fragmentShaderData, VK_SHADER_STAGE_FRAGMENT_BIT);
@@ -156,6 +939,11 @@ namespace vmc
 		RenderPipelineDescription pipelineDescription;
 		pipelineDescription.renderPass = application.getRenderPass().getHandle();
 		pipelineDescription.subpass = 0;
+		pipelineDescription.isAdditiveBlendingEnabled = isOverdrawPipeline;
+		pipelineDescription.pipelineCache = application.getPipelineCache().getHandle();
+
+		// Cross-shaped vegetation is made of single quads that have to be seen from both sides.
+		pipelineDescription.cullMode = part == MeshPart::Opaque ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
 
 		pipelineDescription.shaderModules.push_back(std::move(vertexShader));
 		pipelineDescription.shaderModules.push_back(std::move(fragmentShader));
@@ -164,10 +952,34 @@ namespace vmc
 		pipelineDescription.vertexAttributes.push_back(positionAttribute);
 		pipelineDescription.vertexAttributes.push_back(colorAttribute);
 
+		if (hasChunkOffsetAttribute) {
+			VkVertexInputBindingDescription chunkOffsetBinding{};
+			chunkOffsetBinding.binding = 1;
+			chunkOffsetBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+			chunkOffsetBinding.stride = sizeof(glm::vec4);
+
+			VkVertexInputAttributeDescription chunkOffsetAttribute{};
+			chunkOffsetAttribute.binding = 1;
+			chunkOffsetAttribute.location = 2;
+			chunkOffsetAttribute.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			chunkOffsetAttribute.offset = 0;
+
+			pipelineDescription.vertexBindings.push_back(chunkOffsetBinding);
+			pipelineDescription.vertexAttributes.push_back(chunkOffsetAttribute);
+		}
+		else {
+			VkPushConstantRange chunkOffsetRange{};
+			chunkOffsetRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			chunkOffsetRange.offset = 0;
+			chunkOffsetRange.size = sizeof(ChunkPushConstants);
+
+			pipelineDescription.pushConstantRanges.push_back(chunkOffsetRange);
+		}
+
 		pipelineDescription.descriptorSetLayouts.push_back(application.getMVPLayout().getHandle());
 		pipelineDescription.descriptorSetLayouts.push_back(application.getTextureLayout().getHandle());
 
-		defaultPipeline = std::make_unique<RenderPipeline>(application.getDevice(), pipelineDescription);
+		return std::make_unique<RenderPipeline>(application.getDevice(), pipelineDescription);
 	}
 
     void GameView::initChunks()
@@ -179,12 +991,19 @@ namespace vmc
 	{
         auto& stagingManager = application.getStagingManager();
 		stagingManager.start();
+		std::vector<std::pair<glm::ivec2, Mesh>> meshes;
         for (auto& entry : world.getChunks()) {
             auto& coord = entry.first;
             auto& chunk = entry.second;
-            chunkMeshes.emplace(coord, application.getMeshBuilder().buildChunkMesh(stagingManager, world, chunk, coord));
+            meshes.emplace_back(coord, application.getMeshBuilder().buildChunkMesh(stagingManager, world, chunk, coord));
+            chunkConnectivity[coord] = application.getMeshBuilder().buildChunkConnectivity(chunk);
+            chunkOccluders[coord] = application.getMeshBuilder().buildChunkOccluder(chunk);
         }
-		stagingManager.flush();
+		auto uploadBatch = stagingManager.flush();
+
+		for (auto& entry : meshes) {
+			pendingChunkMeshes.emplace(entry.first, PendingChunkMesh{ std::move(entry.second), uploadBatch });
+		}
 	}
 
 	void GameView::lockCursor()
@@ -241,21 +1060,79 @@ namespace vmc
 		}
 	}
 
-	void GameView::loadNextChunk()
+	VkDeviceSize GameView::loadNextChunk(StagingManager& stagingManager)
 	{
+		VMC_PROFILE_ZONE("load chunk");
 		if (chunksToLoad.empty()) {
-			return;
+			return 0;
 		}
 
 		auto coord = chunksToLoad.front();
 		auto& chunk = world.generateChunk(coord);
 
-		auto& stagingManager = application.getStagingManager();
-		stagingManager.start();
-	    chunkMeshes.emplace(coord, application.getMeshBuilder().buildChunkMesh(stagingManager, world, chunk, coord));
-		stagingManager.flush();
+		auto mesh = application.getMeshBuilder().buildChunkMesh(stagingManager, world, chunk, coord);
+		chunkConnectivity[coord] = application.getMeshBuilder().buildChunkConnectivity(chunk);
+		chunkOccluders[coord] = application.getMeshBuilder().buildChunkOccluder(chunk);
+		VkDeviceSize uploadedBytes = mesh.getSize();
+		// The upload batch is only known once update flushes the batch shared by this frame's chunks.
+		pendingChunkMeshes.emplace(coord, PendingChunkMesh{ std::move(mesh), 0 });
 
 		chunksToLoad.pop_front();
+		return uploadedBytes;
+	}
+
+	void GameView::activateUploadedMeshes()
+	{
+		auto& stagingManager = application.getStagingManager();
+
+		for (auto it = pendingChunkMeshes.begin(); it != pendingChunkMeshes.end();) {
+			if (stagingManager.isCompleted(it->second.uploadBatch)) {
+				if (chunkMeshes.emplace(it->first, std::move(it->second.mesh)).second) {
+					chunkDrawOrder.emplace_back(0.0f, it->first);
+					cachedChunkCommands->invalidate();
+				}
+				it = pendingChunkMeshes.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	void GameView::unloadDistantChunks(const glm::vec3& playerPosition)
+	{
+		auto centerChunk = getChunkCoordinate(playerPosition);
+		auto& renderContext = application.getRenderContext();
+		std::vector<glm::ivec2> chunksToUnload;
+
+		for (auto& entry : world.getChunks()) {
+			auto distance = glm::abs(entry.first - centerChunk);
+			if ((uint32_t)std::max(distance.x, distance.y) > unloadChunkRadius && pendingChunkMeshes.find(entry.first) == pendingChunkMeshes.end()) {
+				chunksToUnload.push_back(entry.first);
+			}
+		}
+
+		for (const auto& coord : chunksToUnload) {
+			auto it = chunkMeshes.find(coord);
+			if (it != chunkMeshes.end()) {
+				renderContext.retire(std::move(it->second));
+				chunkMeshes.erase(it);
+				cachedChunkCommands->invalidate();
+			}
+
+			chunkDrawOrder.erase(std::remove_if(chunkDrawOrder.begin(), chunkDrawOrder.end(), [&](const std::pair<float, glm::ivec2>& order) {
+				return order.second == coord;
+			}), chunkDrawOrder.end());
+
+			chunkConnectivity.erase(coord);
+			chunkOccluders.erase(coord);
+			world.unloadChunk(coord);
+		}
+
+		chunksToLoad.erase(std::remove_if(chunksToLoad.begin(), chunksToLoad.end(), [&](const glm::ivec2& coord) {
+			auto distance = glm::abs(coord - centerChunk);
+			return (uint32_t)std::max(distance.x, distance.y) > unloadChunkRadius;
+		}), chunksToLoad.end());
 	}
 
 	bool GameView::isPendingLoading(const glm::ivec2& coord)
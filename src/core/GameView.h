@@ -3,15 +3,50 @@
 #include "View.h"
 #include <rendering/RenderPipeline.h>
 #include <vk/VulkanBuffer.h>
+#include <vk/StagingManager.h>
 #include <rendering/Camera.h>
 #include <rendering/Mesh.h>
+#include <rendering/Frustum.h>
+#include <rendering/RenderStats.h>
+#include <rendering/IndirectDrawBuffer.h>
+#include <rendering/GpuChunkCuller.h>
+#include <rendering/CaveCuller.h>
+#include <rendering/OcclusionRasterizer.h>
+#include <rendering/CachedCommandBuffer.h>
+#include <rendering/OverlayRenderer.h>
 #include <world/Chunk.h>
 #include <world/World.h>
 #include <queue>
 #include <deque>
+#include <chrono>
 
 namespace vmc
 {
+	struct PendingChunkMesh
+	{
+		Mesh mesh;
+		uint64_t uploadBatch;
+	};
+
+	const float CameraFieldOfView = 55.0f;
+	const float LateLatchFieldOfViewMargin = 5.0f;
+	const float MaxCameraTimeDelta = 0.1f;
+	const float HeadlessCameraPitch = -0.3f;
+	const float HeadlessCameraYawPerFrame = 0.005f;
+	const uint32_t OverlayFrameTimeSamples = 120;
+	const float OverlayGraphHeight = 60.0f;
+	const float OverlayGraphMaxMs = 33.3f;
+
+	enum class ChunkRenderMode
+	{
+		Direct,
+		ParallelDirect,
+		Cached,
+		Indirect,
+		GpuCulled,
+		OcclusionCulled
+	};
+
 	class GameView : public View
 	{
 	public:
@@ -23,24 +58,93 @@ namespace vmc
 
 		virtual void render(RenderContext& renderContext) override;
 
+		const RenderStats& getRenderStats() const;
+
 	private:
-		std::unique_ptr<RenderPipeline> defaultPipeline;
+		std::unique_ptr<RenderPipeline> directPipelines[MeshPartCount];
+		std::unique_ptr<RenderPipeline> indirectPipelines[MeshPartCount];
+		std::unique_ptr<RenderPipeline> overdrawDirectPipelines[MeshPartCount];
+		std::unique_ptr<RenderPipeline> overdrawIndirectPipelines[MeshPartCount];
+		bool isOverdrawVisible = false;
+		std::vector<std::unique_ptr<IndirectDrawBuffer>> indirectDrawBuffers;
+		std::vector<std::pair<uint32_t, uint32_t>> pageDrawRanges;
+		std::vector<uint32_t> visibleChunkIndices;
+		std::vector<VkCommandBuffer> secondaryCommandBuffers;
+		std::vector<uint32_t> workerDrawCalls;
+		std::unique_ptr<CachedCommandBuffer> cachedChunkCommands;
+		std::vector<glm::ivec2> visibleChunkCoords;
+		std::vector<glm::ivec2> cachedVisibleChunkCoords;
+		uint32_t cachedChunkDrawCalls = 0;
+		std::unique_ptr<GpuChunkCuller> gpuChunkCuller;
+		std::unique_ptr<DepthPyramid> depthPyramid;
+		std::unique_ptr<OverlayRenderer> overlay;
+		bool isOverlayVisible = true;
+		std::vector<float> frameTimesMs;
+		uint32_t frameTimeIndex = 0;
+		std::chrono::steady_clock::time_point lastRenderTime;
+		std::string overlayText;
+		ChunkRenderMode chunkRenderMode = ChunkRenderMode::Indirect;
         std::unordered_map<glm::ivec2, Mesh> chunkMeshes;
+		std::unordered_map<glm::ivec2, PendingChunkMesh> pendingChunkMeshes;
 		std::deque<glm::ivec2> chunksToLoad;
+		std::vector<glm::ivec2> uploadingChunks;
+		BoundingBoxList chunkBounds;
+		std::vector<uint8_t> chunkVisibility;
+		std::vector<const std::pair<const glm::ivec2, Mesh>*> chunkDrawList;
+		std::vector<std::pair<float, glm::ivec2>> chunkDrawOrder;
+		std::unordered_map<glm::ivec2, ChunkConnectivity> chunkConnectivity;
+		CaveCuller caveCuller;
+		bool isCaveCullingEnabled = true;
+		std::unordered_map<glm::ivec2, ChunkOccluder> chunkOccluders;
+		OcclusionRasterizer occlusionRasterizer;
+		bool isSoftwareOcclusionEnabled = false;
+		uint32_t occluderChunkRadius = 3;
+		RenderStats renderStats;
 		VkDescriptorSet mainAtlasDescriptor;
 		Camera camera;
         World world;
 		bool isCursorLocked = false;
+		bool isLateLatchEnabled = true;
+		std::chrono::steady_clock::time_point lastCameraUpdateTime = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point inputSampleTime;
 		uint32_t visibleChunkRadius = 4;
+		uint32_t unloadChunkRadius = 8;
 
 		void initPipeline();
+		std::unique_ptr<RenderPipeline> createChunkPipeline(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, bool hasChunkOffsetAttribute, MeshPart part, bool isOverdrawPipeline);
+		const RenderPipeline& getDirectChunkPipeline(MeshPart part) const;
+		const RenderPipeline& getIndirectChunkPipeline(MeshPart part) const;
+		void bindChunkPipeline(VkCommandBuffer commandBuffer, const RenderPipeline& pipeline, const UniformAllocation& viewProjectionUniform);
+		void handleInput();
+		void updateCamera();
+		glm::mat4 getViewProjection(const RenderContext& renderContext, float fieldOfView);
+		void latchCamera(RenderContext& renderContext, const UniformAllocation& viewProjectionUniform);
+		void sortChunkDrawOrder();
+		void recordDirectChunkDraws(RenderContext& renderContext, VkCommandBuffer commandBuffer, const UniformAllocation& viewProjectionUniform);
+		bool recordDirectChunkDraw(VkCommandBuffer commandBuffer, const RenderPipeline& pipeline, MeshPart part, const std::pair<const glm::ivec2, Mesh>& entry);
+		void recordParallelChunkDraws(RenderContext& renderContext, const UniformAllocation& viewProjectionUniform);
+		void recordCachedChunkDraws(RenderContext& renderContext, const glm::mat4& viewProjection);
+		void recordIndirectChunkDraws(RenderContext& renderContext, VkCommandBuffer commandBuffer, const UniformAllocation& viewProjectionUniform);
+		void recordGpuCulledChunkDraws(RenderContext& renderContext, VkCommandBuffer commandBuffer, const UniformAllocation& viewProjectionUniform, const Frustum& frustum);
+		void recordOcclusionCulledChunkDraws(RenderContext& renderContext, VkCommandBuffer commandBuffer, const glm::mat4& viewProjection, const UniformAllocation& viewProjectionUniform, const Frustum& frustum);
+		void recordFrameTime();
+		void recordOverlay(RenderContext& renderContext, VkCommandBuffer commandBuffer);
+		void addGpuCullRecords();
+		void updateGpuCullStats();
+		IndirectDrawBuffer& getIndirectDrawBuffer(RenderContext& renderContext);
+		void switchChunkRenderMode();
+		bool isHiddenByTerrain(const glm::ivec2& coord) const;
+		void rasterizeOccluders(const glm::mat4& viewProjection, const Frustum& frustum);
+		bool isHiddenByOccluders(const glm::ivec2& coord, const Mesh& mesh);
         void initChunks();
 		void initMeshes();
 		void lockCursor();
 		void unlockCursor();
 		void enqueueChunk(int32_t x, int32_t z);
 		void enqueueSurroundingChunks(const glm::vec3& playerPosition);
-		void loadNextChunk();
+		VkDeviceSize loadNextChunk(StagingManager& stagingManager);
+		void activateUploadedMeshes();
+		void unloadDistantChunks(const glm::vec3& playerPosition);
 		bool isPendingLoading(const glm::ivec2& coord);
 	};
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Window.h"
 #include <stdexcept>
+#include <algorithm>
 #include "Application.h"
 
 namespace vmc
@@ -33,6 +34,7 @@ namespace vmc
 		glfwSetWindowUserPointer(handle, this);
 		glfwSetWindowSizeCallback(handle, resizeCallback);
 		glfwSetWindowFocusCallback(handle, focusCallback);
+		glfwSetKeyCallback(handle, keyCallback);
 	}
 
 	Window::~Window()
@@ -72,6 +74,26 @@ namespace vmc
 	void Window::pollEvents()
 	{
 		glfwPollEvents();
+		publishPressedKeys();
+	}
+
+	void Window::waitEvents()
+	{
+		glfwWaitEvents();
+		publishPressedKeys();
+	}
+
+	void Window::pollInputEvents()
+	{
+		// Refreshes key and cursor state in the middle of a frame. Keys pressed now are reported as just pressed by the
+		// next pollEvents, so the frame's update never misses them.
+		glfwPollEvents();
+	}
+
+	void Window::publishPressedKeys()
+	{
+		justPressedKeys.swap(pendingPressedKeys);
+		pendingPressedKeys.clear();
 	}
 
     glm::uvec2 Window::getMousePos() const
@@ -97,6 +119,11 @@ namespace vmc
 		return glfwGetKey(handle, key) == GLFW_PRESS;
     }
 
+	bool Window::isKeyJustPressed(int key) const
+	{
+		return std::find(justPressedKeys.begin(), justPressedKeys.end(), key) != justPressedKeys.end();
+	}
+
 	bool Window::isMouseButtonPressed(int button)
 	{
 		return glfwGetMouseButton(handle, button) == GLFW_PRESS;
@@ -130,6 +157,16 @@ namespace vmc
 		}
 	}
 
+	void Window::keyCallback(GLFWwindow* windowHandle, int key, int scancode, int action, int mods)
+	{
+		if (auto window = reinterpret_cast<Window*>(glfwGetWindowUserPointer(windowHandle)))
+		{
+			if (action == GLFW_PRESS) {
+				window->pendingPressedKeys.push_back(key);
+			}
+		}
+	}
+
 	void addWindowInstanceExtensions(std::vector<const char*>& extensions)
 	{
 		ensureGLFWIsInitialized();
@@ -37,6 +37,10 @@ namespace vmc
 
 		void pollEvents();
 
+		void waitEvents();
+
+		void pollInputEvents();
+
 		glm::uvec2 getMousePos() const;
 
 		void setMousePos(uint32_t x, uint32_t y) const;
@@ -45,6 +49,8 @@ namespace vmc
 
 		bool isKeyPressed(int key);
 
+		bool isKeyJustPressed(int key) const;
+
 		bool isMouseButtonPressed(int button);
 
 	private:
@@ -62,6 +68,12 @@ namespace vmc
 
 		bool focused = true;
 
+		std::vector<int> justPressedKeys;
+
+		std::vector<int> pendingPressedKeys;
+
+		void publishPressedKeys();
+
 		void onResize(uint32_t newWidth, uint32_t newHeight);
 
 		void onFocus(bool focused);
@@ -69,6 +81,8 @@ namespace vmc
 		static void resizeCallback(GLFWwindow* window, int width, int height);
 
 		static void focusCallback(GLFWwindow* window, int focused);
+
+		static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 	};
 
 	void addWindowInstanceExtensions(std::vector<const char*>& extensions);
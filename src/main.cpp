@@ -1,10 +1,10 @@
 #include <iostream>
 #include <core/Application.h>
 
-int main()
+int main(int argc, char** argv)
 {
     try {
-        vmc::Application app(800, 600);
+        vmc::Application app(vmc::parseApplicationSettings(argc, argv));
         app.run();
     }
     catch (std::runtime_error e) {
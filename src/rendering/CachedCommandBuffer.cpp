@@ -0,0 +1,139 @@
+#include "CachedCommandBuffer.h"
+#include <stdexcept>
+#include <cstring>
+
+namespace vmc
+{
+	CachedCommandBuffer::CachedCommandBuffer(const VulkanDevice& device, const DescriptorSetLayout& uniformLayout, VkDeviceSize uniformSize) :
+		device(device),
+		uniformLayout(uniformLayout.getHandle()),
+		uniformSize(uniformSize)
+	{
+		VkCommandPoolCreateInfo createInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+		createInfo.queueFamilyIndex = device.getGraphicsQueueFamilyIndex();
+		createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if (vkCreateCommandPool(device.getHandle(), &createInfo, nullptr, &commandPool) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot create command pool.");
+		}
+	}
+
+	CachedCommandBuffer::~CachedCommandBuffer()
+	{
+		for (auto& slot : slots) {
+			if (slot.uniformData) {
+				slot.uniformBuffer->unmap();
+			}
+		}
+
+		// Freeing the pool frees its command buffers as well.
+		vkDestroyCommandPool(device.getHandle(), commandPool, nullptr);
+	}
+
+	void CachedCommandBuffer::invalidate()
+	{
+		version++;
+	}
+
+	bool CachedCommandBuffer::isValid(RenderContext& renderContext)
+	{
+		auto& slot = getSlot(renderContext);
+
+		// The viewport is part of the recorded commands, so a resized surface needs a new recording too.
+		return slot.recordedVersion == version && slot.recordedExtent.width == renderContext.getWidth() && slot.recordedExtent.height == renderContext.getHeight();
+	}
+
+	VkCommandBuffer CachedCommandBuffer::beginRecording(RenderContext& renderContext)
+	{
+		auto& slot = getSlot(renderContext);
+		renderContext.beginReusableCommandBuffer(slot.commandBuffer);
+		return slot.commandBuffer;
+	}
+
+	void CachedCommandBuffer::endRecording(RenderContext& renderContext)
+	{
+		auto& slot = getSlot(renderContext);
+		renderContext.endSecondaryCommandBuffer(slot.commandBuffer);
+
+		slot.recordedVersion = version;
+		slot.recordedExtent = { renderContext.getWidth(), renderContext.getHeight() };
+	}
+
+	void CachedCommandBuffer::execute(RenderContext& renderContext)
+	{
+		auto& slot = getSlot(renderContext);
+		if (slot.recordedVersion != version) {
+			throw std::runtime_error("Cannot execute a cached command buffer that is not recorded.");
+		}
+
+		renderContext.executeSecondaryCommandBuffers({ slot.commandBuffer });
+	}
+
+	UniformAllocation CachedCommandBuffer::getUniform(RenderContext& renderContext)
+	{
+		auto& slot = getSlot(renderContext);
+
+		UniformAllocation allocation;
+		allocation.descriptorSet = slot.uniformDescriptorSet;
+		allocation.offset = 0;
+		allocation.data = slot.uniformData;
+		return allocation;
+	}
+
+	void CachedCommandBuffer::setUniform(RenderContext& renderContext, const void* data, VkDeviceSize size)
+	{
+		if (size > uniformSize) {
+			throw std::runtime_error("Cannot set uniform larger than the cached uniform slot.");
+		}
+
+		// The slot belongs to the current frame resource, whose previous submission has already been waited for.
+		auto& slot = getSlot(renderContext);
+		memcpy(slot.uniformData, data, size);
+		if (!slot.uniformBuffer->isHostCoherent()) {
+			slot.uniformBuffer->flush(0, size);
+		}
+	}
+
+	CachedCommandSlot& CachedCommandBuffer::getSlot(RenderContext& renderContext)
+	{
+		while (slots.size() < renderContext.getFrameResourceCount()) {
+			CachedCommandSlot slot;
+
+			VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+			allocateInfo.commandPool = commandPool;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocateInfo.commandBufferCount = 1;
+
+			if (vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &slot.commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot allocate command buffer.");
+			}
+
+			slot.uniformBuffer = std::make_unique<VulkanBuffer>(device, uniformSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+			slot.uniformData = slot.uniformBuffer->map();
+
+			VkDescriptorPoolSize poolSize{};
+			poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			poolSize.descriptorCount = 1;
+			slot.descriptorPool = std::make_unique<DescriptorPool>(device, std::vector<VkDescriptorPoolSize>{ poolSize }, 1);
+			slot.uniformDescriptorSet = slot.descriptorPool->allocate(uniformLayout);
+
+			VkDescriptorBufferInfo bufferInfo{};
+			bufferInfo.buffer = slot.uniformBuffer->getHandle();
+			bufferInfo.offset = 0;
+			bufferInfo.range = uniformSize;
+
+			VkWriteDescriptorSet writeInfo{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+			writeInfo.descriptorCount = 1;
+			writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			writeInfo.dstBinding = 0;
+			writeInfo.pBufferInfo = &bufferInfo;
+			writeInfo.dstSet = slot.uniformDescriptorSet;
+
+			vkUpdateDescriptorSets(device.getHandle(), 1, &writeInfo, 0, nullptr);
+
+			slots.push_back(std::move(slot));
+		}
+
+		return slots[renderContext.getFrameResourceIndex()];
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <rendering/RenderContext.h>
+#include <vk/DescriptorPool.h>
+#include <vk/DescriptorSetLayout.h>
+#include <vk/UniformAllocator.h>
+#include <vk/VulkanBuffer.h>
+#include <memory>
+#include <vector>
+
+namespace vmc
+{
+	struct CachedCommandSlot
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		std::unique_ptr<VulkanBuffer> uniformBuffer;
+		std::unique_ptr<DescriptorPool> descriptorPool;
+		VkDescriptorSet uniformDescriptorSet = VK_NULL_HANDLE;
+		void* uniformData = nullptr;
+		uint64_t recordedVersion = 0;
+		VkExtent2D recordedExtent{};
+	};
+
+	// Secondary command buffer that is recorded once and executed every frame until it is invalidated. Each frame resource
+	// has its own copy, together with a uniform slot at a fixed address, so values referenced by the recorded commands can
+	// be rewritten every frame without recording anything.
+	class CachedCommandBuffer
+	{
+	public:
+		CachedCommandBuffer(const VulkanDevice& device, const DescriptorSetLayout& uniformLayout, VkDeviceSize uniformSize = DefaultUniformDescriptorRange);
+
+		CachedCommandBuffer(const CachedCommandBuffer&) = delete;
+
+		CachedCommandBuffer(CachedCommandBuffer&& other) = delete;
+
+		~CachedCommandBuffer();
+
+		CachedCommandBuffer& operator=(const CachedCommandBuffer&) = delete;
+
+		CachedCommandBuffer& operator=(CachedCommandBuffer&&) = delete;
+
+		void invalidate();
+
+		bool isValid(RenderContext& renderContext);
+
+		VkCommandBuffer beginRecording(RenderContext& renderContext);
+
+		void endRecording(RenderContext& renderContext);
+
+		void execute(RenderContext& renderContext);
+
+		UniformAllocation getUniform(RenderContext& renderContext);
+
+		void setUniform(RenderContext& renderContext, const void* data, VkDeviceSize size);
+
+		template<typename T>
+		void setUniform(RenderContext& renderContext, const T& value)
+		{
+			setUniform(renderContext, &value, sizeof(T));
+		}
+
+	private:
+		const VulkanDevice& device;
+
+		VkDescriptorSetLayout uniformLayout;
+
+		VkDeviceSize uniformSize;
+
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+
+		std::vector<CachedCommandSlot> slots;
+
+		uint64_t version = 1;
+
+		CachedCommandSlot& getSlot(RenderContext& renderContext);
+	};
+}
@@ -0,0 +1,82 @@
+#include "CaveCuller.h"
+#include <algorithm>
+#include <cmath>
+
+namespace vmc
+{
+    const uint32_t NoEntryFace = SectionFaceCount;
+
+    void CaveCuller::update(const glm::vec3& cameraPosition, const Frustum& frustum, const std::unordered_map<glm::ivec2, ChunkConnectivity>& connectivity)
+    {
+        visitedSections.clear();
+        queue.clear();
+
+        glm::ivec3 start(
+            (int32_t)std::floor(cameraPosition.x / SectionSize),
+            std::clamp((int32_t)std::floor(cameraPosition.y / SectionSize), 0, (int32_t)SectionsPerChunk - 1),
+            (int32_t)std::floor(cameraPosition.z / SectionSize));
+
+        // Without the camera's chunk there is nothing to start the walk from, so nothing is hidden.
+        isActive = connectivity.find(glm::ivec2(start.x, start.z)) != connectivity.end();
+        if (!isActive) {
+            return;
+        }
+
+        visitedSections[glm::ivec2(start.x, start.z)] |= 1 << start.y;
+        queue.push_back({ start, NoEntryFace, 0 });
+
+        for (size_t head = 0; head < queue.size(); head++) {
+            auto node = queue[head];
+            const auto& section = connectivity.at(glm::ivec2(node.section.x, node.section.z)).sections[node.section.y];
+
+            for (uint32_t face = 0; face < SectionFaceCount; face++) {
+                uint32_t oppositeFace = face ^ 1;
+                if (node.directions & (1 << oppositeFace)) {
+                    continue;
+                }
+
+                if (node.entryFace != NoEntryFace && !section.isConnected(node.entryFace, face)) {
+                    continue;
+                }
+
+                auto next = node.section + SectionFaceDirections[face];
+                if (next.y < 0 || next.y >= (int32_t)SectionsPerChunk) {
+                    continue;
+                }
+
+                glm::ivec2 chunkCoord(next.x, next.z);
+                if (connectivity.find(chunkCoord) == connectivity.end()) {
+                    continue;
+                }
+
+                auto& visited = visitedSections[chunkCoord];
+                if (visited & (1 << next.y)) {
+                    continue;
+                }
+
+                glm::vec3 boundsMin = glm::vec3(next) * (float)SectionSize;
+                if (!frustum.isBoxVisible(boundsMin, boundsMin + glm::vec3((float)SectionSize))) {
+                    continue;
+                }
+
+                visited |= 1 << next.y;
+                queue.push_back({ next, oppositeFace, node.directions | (1u << face) });
+            }
+        }
+    }
+
+    bool CaveCuller::isChunkVisible(const glm::ivec2& coord) const
+    {
+        if (!isActive) {
+            return true;
+        }
+
+        auto it = visitedSections.find(coord);
+        return it != visitedSections.end() && it->second != 0;
+    }
+
+    uint32_t CaveCuller::getVisitedSectionCount() const
+    {
+        return (uint32_t)queue.size();
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <rendering/Frustum.h>
+#include <world/World.h>
+#include <vector>
+
+namespace vmc
+{
+    constexpr uint32_t SectionSize = 16;
+    constexpr uint32_t SectionsPerChunk = ChunkHeight / SectionSize;
+    constexpr uint32_t SectionFaceCount = 6;
+
+    // Faces are ordered -X, +X, -Y, +Y, -Z, +Z, so the opposite of a face is face ^ 1.
+    const glm::ivec3 SectionFaceDirections[SectionFaceCount]
+    {
+        {-1, 0, 0},
+        {1, 0, 0},
+        {0, -1, 0},
+        {0, 1, 0},
+        {0, 0, -1},
+        {0, 0, 1}
+    };
+
+    struct SectionConnectivity
+    {
+        uint64_t faceMask = 0;
+
+        void connect(uint32_t from, uint32_t to)
+        {
+            faceMask |= 1ull << (from * SectionFaceCount + to);
+            faceMask |= 1ull << (to * SectionFaceCount + from);
+        }
+
+        void connectAll()
+        {
+            faceMask = (1ull << (SectionFaceCount * SectionFaceCount)) - 1;
+        }
+
+        bool isConnected(uint32_t from, uint32_t to) const
+        {
+            return (faceMask & (1ull << (from * SectionFaceCount + to))) != 0;
+        }
+    };
+
+    struct ChunkConnectivity
+    {
+        SectionConnectivity sections[SectionsPerChunk];
+    };
+
+    // Walks the section graph outwards from the camera, only leaving a section through faces that are connected to the face it
+    // was entered through, and never turning back against a direction already travelled. Chunks none of whose sections are
+    // reached are hidden behind terrain.
+    class CaveCuller
+    {
+    public:
+        void update(const glm::vec3& cameraPosition, const Frustum& frustum, const std::unordered_map<glm::ivec2, ChunkConnectivity>& connectivity);
+
+        bool isChunkVisible(const glm::ivec2& coord) const;
+
+        uint32_t getVisitedSectionCount() const;
+
+    private:
+        struct SectionNode
+        {
+            glm::ivec3 section;
+            uint32_t entryFace;
+            uint32_t directions;
+        };
+
+        std::unordered_map<glm::ivec2, uint16_t> visitedSections;
+
+        std::vector<SectionNode> queue;
+
+        bool isActive = false;
+    };
+}
@@ -0,0 +1,51 @@
+#include "ComputePipeline.h"
+#include <stdexcept>
+
+namespace vmc
+{
+	ComputePipeline::ComputePipeline(const VulkanDevice& device, const VulkanShaderModule& shaderModule, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges, VkPipelineCache pipelineCache) :
+		device(device)
+	{
+		VkPipelineLayoutCreateInfo layoutCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+		layoutCreateInfo.setLayoutCount = descriptorSetLayouts.size();
+		layoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
+		layoutCreateInfo.pushConstantRangeCount = pushConstantRanges.size();
+		layoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+
+		if (vkCreatePipelineLayout(device.getHandle(), &layoutCreateInfo, nullptr, &layout) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot create pipeline layout.");
+		}
+
+		VkComputePipelineCreateInfo createInfo{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+		createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		createInfo.stage.module = shaderModule.getHandle();
+		createInfo.stage.pName = "main";
+		createInfo.layout = layout;
+
+		if (vkCreateComputePipelines(device.getHandle(), pipelineCache, 1, &createInfo, nullptr, &handle) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot create compute pipeline.");
+		}
+	}
+
+	ComputePipeline::~ComputePipeline()
+	{
+		if (handle != VK_NULL_HANDLE) {
+			vkDestroyPipeline(device.getHandle(), handle, nullptr);
+		}
+
+		if (layout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(device.getHandle(), layout, nullptr);
+		}
+	}
+
+	VkPipeline ComputePipeline::getHandle() const
+	{
+		return handle;
+	}
+
+	VkPipelineLayout ComputePipeline::getLayout() const
+	{
+		return layout;
+	}
+}
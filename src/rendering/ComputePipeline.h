@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vk/VulkanDevice.h>
+#include <vk/ShaderModule.h>
+
+namespace vmc
+{
+	class ComputePipeline
+	{
+	public:
+		ComputePipeline(const VulkanDevice& device, const VulkanShaderModule& shaderModule, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges = {}, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+
+		ComputePipeline(const ComputePipeline&) = delete;
+
+		ComputePipeline(ComputePipeline&&) = delete;
+
+		~ComputePipeline();
+
+		ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+		ComputePipeline& operator=(ComputePipeline&&) = delete;
+
+		VkPipeline getHandle() const;
+
+		VkPipelineLayout getLayout() const;
+
+	private:
+		const VulkanDevice& device;
+
+		VkPipeline handle = VK_NULL_HANDLE;
+
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+	};
+}
@@ -0,0 +1,294 @@
+#include "DepthPyramid.h"
+#include "RenderContext.h"
+#include <common/Utils.h>
+#include <vk/ShaderModule.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace vmc
+{
+	const uint32_t DepthPyramidWorkgroupSize = 8;
+
+	struct DepthPyramidParameters
+	{
+		glm::ivec2 sourceSize;
+		glm::ivec2 destinationSize;
+	};
+
+	static uint32_t previousPowerOfTwo(uint32_t value)
+	{
+		uint32_t result = 1;
+		while (result * 2 <= value) {
+			result *= 2;
+		}
+		return result;
+	}
+
+	DepthPyramid::DepthPyramid(const VulkanDevice& device, VkPipelineCache pipelineCache) :
+		device(device),
+		viewProjection(1.0f)
+	{
+		VkDescriptorSetLayoutBinding sourceBinding{};
+		sourceBinding.binding = 0;
+		sourceBinding.descriptorCount = 1;
+		sourceBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		sourceBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkDescriptorSetLayoutBinding destinationBinding{};
+		destinationBinding.binding = 1;
+		destinationBinding.descriptorCount = 1;
+		destinationBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		destinationBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		descriptorSetLayout = std::make_unique<DescriptorSetLayout>(device, std::vector<VkDescriptorSetLayoutBinding>{ sourceBinding, destinationBinding });
+
+		auto shaderData = readBinaryFile("data/shaders/depth_pyramid.comp.spv");
+		VulkanShaderModule shaderModule(device, shaderData, VK_SHADER_STAGE_COMPUTE_BIT);
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(DepthPyramidParameters);
+
+		pipeline = std::make_unique<ComputePipeline>(device, shaderModule, std::vector<VkDescriptorSetLayout>{ descriptorSetLayout->getHandle() }, std::vector<VkPushConstantRange>{ pushConstantRange }, pipelineCache);
+
+		// Texels are always fetched explicitly, the sampler only has to exist for the combined image sampler descriptors.
+		VkSamplerCreateInfo samplerInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = 16.0f;
+
+		if (vkCreateSampler(device.getHandle(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot create sampler.");
+		}
+	}
+
+	DepthPyramid::~DepthPyramid()
+	{
+		descriptorPool.reset();
+		levelViews.clear();
+		view.reset();
+		image.reset();
+
+		if (sampler != VK_NULL_HANDLE) {
+			vkDestroySampler(device.getHandle(), sampler, nullptr);
+		}
+	}
+
+	bool DepthPyramid::isSupported(const VulkanDevice& device)
+	{
+		return device.isDepthSamplingSupported() && device.isGraphicsQueueComputeSupported();
+	}
+
+	void DepthPyramid::prepare(RenderContext& renderContext, VkCommandBuffer commandBuffer)
+	{
+		uint32_t width = previousPowerOfTwo(renderContext.getWidth());
+		uint32_t height = previousPowerOfTwo(renderContext.getHeight());
+
+		if (!image || image->getWidth() != width || image->getHeight() != height || descriptorSets.size() != renderContext.getFrameResourceCount()) {
+			resize(renderContext, width, height);
+		}
+
+		if (isLayoutInitialized) {
+			return;
+		}
+
+		// Culling binds the pyramid before the first build, so it has to be in its working layout even while it holds no depth.
+		VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image->getHandle();
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = image->getMipLevels();
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		isLayoutInitialized = true;
+	}
+
+	void DepthPyramid::build(RenderContext& renderContext, VkCommandBuffer commandBuffer, const glm::mat4& viewProjection)
+	{
+		prepare(renderContext, commandBuffer);
+
+		uint32_t depthWidth = renderContext.getWidth();
+		uint32_t depthHeight = renderContext.getHeight();
+		uint32_t width = image->getWidth();
+		uint32_t height = image->getHeight();
+
+		const auto& sets = descriptorSets[renderContext.getFrameResourceIndex()];
+		updateDescriptorSets(sets, renderContext.getDepthImageView().getHandle());
+
+		auto& gpuProfiler = renderContext.getGpuProfiler();
+		auto gpuScope = gpuProfiler.beginScope(commandBuffer, "depth pyramid", device.getGraphicsQueueFamilyIndex());
+
+		VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image->getHandle();
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = image->getMipLevels();
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+		// The first culling pass of this frame reads the previous pyramid from the same queue before it is overwritten.
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->getHandle());
+
+		glm::ivec2 sourceSize(depthWidth, depthHeight);
+		for (uint32_t level = 0; level < image->getMipLevels(); level++) {
+			glm::ivec2 destinationSize(std::max(width >> level, 1u), std::max(height >> level, 1u));
+
+			DepthPyramidParameters parameters;
+			parameters.sourceSize = sourceSize;
+			parameters.destinationSize = destinationSize;
+
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->getLayout(), 0, 1, &sets[level], 0, nullptr);
+			vkCmdPushConstants(commandBuffer, pipeline->getLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthPyramidParameters), &parameters);
+			vkCmdDispatch(commandBuffer, (destinationSize.x + DepthPyramidWorkgroupSize - 1) / DepthPyramidWorkgroupSize, (destinationSize.y + DepthPyramidWorkgroupSize - 1) / DepthPyramidWorkgroupSize, 1);
+
+			barrier.subresourceRange.baseMipLevel = level;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			sourceSize = destinationSize;
+		}
+
+		gpuProfiler.endScope(commandBuffer, gpuScope);
+		this->viewProjection = viewProjection;
+		valid = true;
+	}
+
+	bool DepthPyramid::isValid() const
+	{
+		return valid;
+	}
+
+	const glm::mat4& DepthPyramid::getViewProjection() const
+	{
+		return viewProjection;
+	}
+
+	VkImageView DepthPyramid::getView() const
+	{
+		return view ? view->getHandle() : VK_NULL_HANDLE;
+	}
+
+	VkSampler DepthPyramid::getSampler() const
+	{
+		return sampler;
+	}
+
+	uint32_t DepthPyramid::getWidth() const
+	{
+		return image ? image->getWidth() : 0;
+	}
+
+	uint32_t DepthPyramid::getHeight() const
+	{
+		return image ? image->getHeight() : 0;
+	}
+
+	uint32_t DepthPyramid::getMipLevels() const
+	{
+		return image ? image->getMipLevels() : 0;
+	}
+
+	void DepthPyramid::resize(RenderContext& renderContext, uint32_t width, uint32_t height)
+	{
+		// Frames still in flight may read the old pyramid, so it is retired with the current frame instead of destroyed.
+		if (image) {
+			renderContext.retire(std::move(descriptorPool));
+			for (auto& levelView : levelViews) {
+				renderContext.retire(std::move(levelView));
+			}
+			renderContext.retire(std::move(*view));
+			renderContext.retire(std::move(*image));
+		}
+
+		descriptorSets.clear();
+		descriptorPool.reset();
+		levelViews.clear();
+		view.reset();
+		image.reset();
+
+		uint32_t frameCount = renderContext.getFrameResourceCount();
+
+		uint32_t mipLevels = 1;
+		while ((std::max(width, height) >> mipLevels) > 0) {
+			mipLevels++;
+		}
+
+		image = std::make_unique<VulkanImage>(device, width, height, VK_FORMAT_R32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY, mipLevels);
+		view = std::make_unique<VulkanImageView>(device, *image, VK_IMAGE_ASPECT_COLOR_BIT);
+		for (uint32_t level = 0; level < mipLevels; level++) {
+			levelViews.emplace_back(device, image->getHandle(), image->getFormat(), VK_IMAGE_ASPECT_COLOR_BIT, 1, level);
+		}
+
+		uint32_t setCount = frameCount * mipLevels;
+		std::vector<VkDescriptorPoolSize> poolSizes(2);
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[0].descriptorCount = setCount;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		poolSizes[1].descriptorCount = setCount;
+		descriptorPool = std::make_unique<DescriptorPool>(device, poolSizes, setCount);
+
+		descriptorSets.resize(frameCount);
+		for (auto& sets : descriptorSets) {
+			for (uint32_t level = 0; level < mipLevels; level++) {
+				sets.push_back(descriptorPool->allocate(descriptorSetLayout->getHandle()));
+			}
+		}
+
+		valid = false;
+		isLayoutInitialized = false;
+	}
+
+	void DepthPyramid::updateDescriptorSets(const std::vector<VkDescriptorSet>& sets, VkImageView depthView)
+	{
+		std::vector<VkDescriptorImageInfo> imageInfos(sets.size() * 2);
+		std::vector<VkWriteDescriptorSet> writes(sets.size() * 2);
+
+		for (uint32_t level = 0; level < sets.size(); level++) {
+			auto& sourceInfo = imageInfos[level * 2];
+			sourceInfo.sampler = sampler;
+			sourceInfo.imageView = level == 0 ? depthView : levelViews[level - 1].getHandle();
+			sourceInfo.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+			auto& destinationInfo = imageInfos[level * 2 + 1];
+			destinationInfo.imageView = levelViews[level].getHandle();
+			destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			for (uint32_t binding = 0; binding < 2; binding++) {
+				auto& write = writes[level * 2 + binding];
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.dstSet = sets[level];
+				write.dstBinding = binding;
+				write.descriptorCount = 1;
+				write.descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+				write.pImageInfo = &imageInfos[level * 2 + binding];
+			}
+		}
+
+		vkUpdateDescriptorSets(device.getHandle(), writes.size(), writes.data(), 0, nullptr);
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vk/VulkanImage.h>
+#include <vk/DescriptorPool.h>
+#include <vk/DescriptorSetLayout.h>
+#include <rendering/ComputePipeline.h>
+#include <glm/glm.hpp>
+#include <memory>
+
+namespace vmc
+{
+	class RenderContext;
+
+	// Max-reduced mip chain of the depth buffer, used to reject chunks whose nearest depth lies behind everything
+	// already drawn over their screen rectangle. The base level is the largest power of two not exceeding the depth extent.
+	class DepthPyramid
+	{
+	public:
+		DepthPyramid(const VulkanDevice& device, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+
+		DepthPyramid(const DepthPyramid&) = delete;
+
+		DepthPyramid(DepthPyramid&& other) = delete;
+
+		~DepthPyramid();
+
+		DepthPyramid& operator=(const DepthPyramid&) = delete;
+
+		DepthPyramid& operator=(DepthPyramid&&) = delete;
+
+		static bool isSupported(const VulkanDevice& device);
+
+		void prepare(RenderContext& renderContext, VkCommandBuffer commandBuffer);
+
+		void build(RenderContext& renderContext, VkCommandBuffer commandBuffer, const glm::mat4& viewProjection);
+
+		bool isValid() const;
+
+		const glm::mat4& getViewProjection() const;
+
+		VkImageView getView() const;
+
+		VkSampler getSampler() const;
+
+		uint32_t getWidth() const;
+
+		uint32_t getHeight() const;
+
+		uint32_t getMipLevels() const;
+
+	private:
+		const VulkanDevice& device;
+
+		std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
+
+		std::unique_ptr<ComputePipeline> pipeline;
+
+		VkSampler sampler = VK_NULL_HANDLE;
+
+		std::unique_ptr<VulkanImage> image;
+
+		std::unique_ptr<VulkanImageView> view;
+
+		std::vector<VulkanImageView> levelViews;
+
+		std::unique_ptr<DescriptorPool> descriptorPool;
+
+		std::vector<std::vector<VkDescriptorSet>> descriptorSets;
+
+		glm::mat4 viewProjection;
+
+		bool valid = false;
+
+		bool isLayoutInitialized = false;
+
+		void resize(RenderContext& renderContext, uint32_t width, uint32_t height);
+
+		void updateDescriptorSets(const std::vector<VkDescriptorSet>& sets, VkImageView depthView);
+	};
+}
@@ -0,0 +1,85 @@
+#include "Frustum.h"
+
+namespace vmc
+{
+    Frustum::Frustum(const glm::mat4& viewProjection)
+    {
+        glm::vec4 rows[4];
+        for (uint32_t i = 0; i < 4; i++) {
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        }
+
+        planes[0] = rows[3] + rows[0];
+        planes[1] = rows[3] - rows[0];
+        planes[2] = rows[3] + rows[1];
+        planes[3] = rows[3] - rows[1];
+        planes[4] = rows[3] + rows[2];
+        planes[5] = rows[3] - rows[2];
+    }
+
+    bool Frustum::isBoxVisible(const glm::vec3& min, const glm::vec3& max) const
+    {
+        for (const auto& plane : planes) {
+            float x = plane.x > 0.0f ? max.x : min.x;
+            float y = plane.y > 0.0f ? max.y : min.y;
+            float z = plane.z > 0.0f ? max.z : min.z;
+
+            if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    const glm::vec4& Frustum::getPlane(uint32_t index) const
+    {
+        return planes[index];
+    }
+
+    void BoundingBoxList::clear()
+    {
+        minX.clear();
+        minY.clear();
+        minZ.clear();
+        maxX.clear();
+        maxY.clear();
+        maxZ.clear();
+    }
+
+    void BoundingBoxList::add(const glm::vec3& min, const glm::vec3& max)
+    {
+        minX.push_back(min.x);
+        minY.push_back(min.y);
+        minZ.push_back(min.z);
+        maxX.push_back(max.x);
+        maxY.push_back(max.y);
+        maxZ.push_back(max.z);
+    }
+
+    size_t BoundingBoxList::size() const
+    {
+        return minX.size();
+    }
+
+    void BoundingBoxList::cull(const Frustum& frustum, std::vector<uint8_t>& visibility) const
+    {
+        size_t count = size();
+        visibility.assign(count, 1);
+
+        for (uint32_t i = 0; i < 6; i++) {
+            const auto& plane = frustum.getPlane(i);
+
+            // Picking the corner furthest along the plane normal once per plane keeps the inner loop branch-free.
+            const float* xs = plane.x > 0.0f ? maxX.data() : minX.data();
+            const float* ys = plane.y > 0.0f ? maxY.data() : minY.data();
+            const float* zs = plane.z > 0.0f ? maxZ.data() : minZ.data();
+            uint8_t* result = visibility.data();
+
+            for (size_t j = 0; j < count; j++) {
+                float distance = plane.x * xs[j] + plane.y * ys[j] + plane.z * zs[j] + plane.w;
+                result[j] &= (uint8_t)(distance >= 0.0f);
+            }
+        }
+    }
+}
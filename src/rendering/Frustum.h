@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace vmc
+{
+    class Frustum
+    {
+    public:
+        Frustum(const glm::mat4& viewProjection);
+
+        bool isBoxVisible(const glm::vec3& min, const glm::vec3& max) const;
+
+        const glm::vec4& getPlane(uint32_t index) const;
+
+    private:
+        glm::vec4 planes[6];
+    };
+
+    class BoundingBoxList
+    {
+    public:
+        void clear();
+
+        void add(const glm::vec3& min, const glm::vec3& max);
+
+        size_t size() const;
+
+        void cull(const Frustum& frustum, std::vector<uint8_t>& visibility) const;
+
+    private:
+        std::vector<float> minX;
+
+        std::vector<float> minY;
+
+        std::vector<float> minZ;
+
+        std::vector<float> maxX;
+
+        std::vector<float> maxY;
+
+        std::vector<float> maxZ;
+    };
+}
@@ -0,0 +1,522 @@
+#include "GpuChunkCuller.h"
+#include "RenderContext.h"
+#include <common/Utils.h>
+#include <common/Profiler.h>
+#include <vk/ShaderModule.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace vmc
+{
+	GpuChunkCuller::GpuChunkCuller(const VulkanDevice& device, const DescriptorSetLayout& uniformLayout, VkPipelineCache pipelineCache) :
+		device(device)
+	{
+		hasDrawIndirectCount = device.isExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		for (uint32_t i = 0; i < 4; i++) {
+			VkDescriptorSetLayoutBinding binding{};
+			binding.binding = i;
+			binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			binding.descriptorCount = 1;
+			binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			bindings.push_back(binding);
+		}
+		descriptorSetLayout = std::make_unique<DescriptorSetLayout>(device, bindings);
+
+		auto shaderData = readBinaryFile("data/shaders/chunk_cull.comp.spv");
+		VulkanShaderModule shaderModule(device, shaderData, VK_SHADER_STAGE_COMPUTE_BIT);
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(GpuCullParameters);
+
+		pipeline = std::make_unique<ComputePipeline>(device, shaderModule, std::vector<VkDescriptorSetLayout>{ descriptorSetLayout->getHandle() }, std::vector<VkPushConstantRange>{ pushConstantRange }, pipelineCache);
+
+		if (DepthPyramid::isSupported(device)) {
+			for (uint32_t i = 4; i < 6; i++) {
+				VkDescriptorSetLayoutBinding binding{};
+				binding.binding = i;
+				binding.descriptorType = i == 4 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				binding.descriptorCount = 1;
+				binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+				bindings.push_back(binding);
+			}
+			occlusionDescriptorSetLayout = std::make_unique<DescriptorSetLayout>(device, bindings);
+
+			auto occlusionShaderData = readBinaryFile("data/shaders/chunk_occlusion_cull.comp.spv");
+			VulkanShaderModule occlusionShaderModule(device, occlusionShaderData, VK_SHADER_STAGE_COMPUTE_BIT);
+
+			VkPushConstantRange occlusionPushConstantRange{};
+			occlusionPushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			occlusionPushConstantRange.offset = 0;
+			occlusionPushConstantRange.size = sizeof(GpuOcclusionParameters);
+
+			std::vector<VkDescriptorSetLayout> occlusionSetLayouts = { occlusionDescriptorSetLayout->getHandle(), uniformLayout.getHandle() };
+			occlusionPipeline = std::make_unique<ComputePipeline>(device, occlusionShaderModule, occlusionSetLayouts, std::vector<VkPushConstantRange>{ occlusionPushConstantRange }, pipelineCache);
+		}
+
+		VkCommandPoolCreateInfo poolCreateInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolCreateInfo.queueFamilyIndex = device.getComputeQueueFamilyIndex();
+
+		if (vkCreateCommandPool(device.getHandle(), &poolCreateInfo, nullptr, &commandPool) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot create command pool.");
+		}
+	}
+
+	GpuChunkCuller::~GpuChunkCuller()
+	{
+		for (auto& frame : frames) {
+			if (!frame) {
+				continue;
+			}
+
+			if (frame->cullFinishedSemaphore != VK_NULL_HANDLE) {
+				vkDestroySemaphore(device.getHandle(), frame->cullFinishedSemaphore, nullptr);
+			}
+		}
+		frames.clear();
+
+		if (commandPool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(device.getHandle(), commandPool, nullptr);
+		}
+	}
+
+	bool GpuChunkCuller::isSupported(const VulkanDevice& device)
+	{
+		// Instance data is addressed through firstInstance, and without a GPU draw count every bucket is drawn with one multi-draw.
+		const auto& features = device.getEnabledFeatures();
+		if (!features.drawIndirectFirstInstance) {
+			return false;
+		}
+
+		return features.multiDrawIndirect || device.isExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	}
+
+	bool GpuChunkCuller::isOcclusionSupported() const
+	{
+		return occlusionPipeline != nullptr;
+	}
+
+	void GpuChunkCuller::reset()
+	{
+		records.clear();
+	}
+
+	void GpuChunkCuller::add(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& chunkOffset, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t page, MeshPart part)
+	{
+		GpuChunkRecord record{};
+		record.boundsMin = glm::vec4(boundsMin, 0.0f);
+		record.boundsMax = glm::vec4(boundsMax, 0.0f);
+		record.chunkOffset = glm::vec4(chunkOffset, 0.0f);
+		record.indexCount = indexCount;
+		record.firstIndex = firstIndex;
+		record.vertexOffset = vertexOffset;
+		record.page = page;
+		record.part = (uint32_t)part;
+		records.push_back(record);
+	}
+
+	void GpuChunkCuller::dispatch(RenderContext& renderContext, const Frustum& frustum, uint32_t pageCount)
+	{
+		VMC_PROFILE_ZONE("dispatch chunk cull");
+		auto& frame = prepareFrame(renderContext, pageCount);
+		frame.passCount = 1;
+		recordCommands(renderContext, frame, frustum);
+
+		VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &frame.computeCommandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &frame.cullFinishedSemaphore;
+
+		if (vkQueueSubmit(device.getComputeQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot submit command buffer.");
+		}
+
+		renderContext.addWaitSemaphore(frame.cullFinishedSemaphore, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+		frame.isSubmitted = true;
+	}
+
+	void GpuChunkCuller::recordOcclusionFirstPass(RenderContext& renderContext, VkCommandBuffer commandBuffer, const Frustum& frustum, const DepthPyramid& depthPyramid, uint32_t pageCount)
+	{
+		auto& frame = prepareFrame(renderContext, pageCount);
+		frame.passCount = GpuCullPassCount;
+		updateOcclusionDescriptorSet(frame, depthPyramid);
+
+		auto& gpuProfiler = renderContext.getGpuProfiler();
+		auto gpuScope = gpuProfiler.beginScope(commandBuffer, "occlusion cull", device.getGraphicsQueueFamilyIndex());
+
+		vkCmdFillBuffer(commandBuffer, frame.countBuffer->getHandle(), 0, VK_WHOLE_SIZE, 0);
+
+		VkMemoryBarrier clearBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+		// Without a pyramid from an earlier frame the first pass is a plain frustum cull and the second pass catches nothing.
+		recordOcclusionPass(renderContext, commandBuffer, frustum, depthPyramid.getViewProjection(), depthPyramid, 0, depthPyramid.isValid());
+
+		VkMemoryBarrier drawBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		drawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		drawBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &drawBarrier, 0, nullptr, 0, nullptr);
+		gpuProfiler.endScope(commandBuffer, gpuScope);
+	}
+
+	void GpuChunkCuller::recordOcclusionSecondPass(RenderContext& renderContext, VkCommandBuffer commandBuffer, const Frustum& frustum, const glm::mat4& viewProjection, const DepthPyramid& depthPyramid)
+	{
+		if (!currentFrame || currentFrame->passCount != GpuCullPassCount) {
+			return;
+		}
+
+		auto& gpuProfiler = renderContext.getGpuProfiler();
+		auto gpuScope = gpuProfiler.beginScope(commandBuffer, "occlusion cull", device.getGraphicsQueueFamilyIndex());
+		recordOcclusionPass(renderContext, commandBuffer, frustum, viewProjection, depthPyramid, 1, depthPyramid.isValid());
+
+		VkMemoryBarrier drawBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		drawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		drawBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &drawBarrier, 0, nullptr, 0, nullptr);
+		gpuProfiler.endScope(commandBuffer, gpuScope);
+	}
+
+	GpuCullFrame& GpuChunkCuller::prepareFrame(RenderContext& renderContext, uint32_t pageCount)
+	{
+		// The frame slot was waited on in startFrame, and its graphics submission waited on the previous cull, so the slot is idle.
+		auto& frame = getFrame(renderContext.getFrameResourceIndex());
+		readVisibleCount(frame);
+
+		// Records are grouped by bucket so that the compacted draws of a bucket occupy one contiguous range of the command buffer.
+		uint32_t bucketCount = pageCount * MeshPartCount;
+		for (auto& record : records) {
+			record.bucket = record.part * pageCount + record.page;
+		}
+
+		std::stable_sort(records.begin(), records.end(), [](const GpuChunkRecord& a, const GpuChunkRecord& b) {
+			return a.bucket < b.bucket;
+		});
+
+		bucketFirstRecords.assign(bucketCount, 0);
+		bucketRecordCounts.assign(bucketCount, 0);
+		for (const auto& record : records) {
+			bucketRecordCounts[record.bucket]++;
+		}
+		for (uint32_t bucket = 1; bucket < bucketCount; bucket++) {
+			bucketFirstRecords[bucket] = bucketFirstRecords[bucket - 1] + bucketRecordCounts[bucket - 1];
+		}
+		for (auto& record : records) {
+			record.outputBase = bucketFirstRecords[record.bucket];
+		}
+
+		uint32_t recordCount = (uint32_t)records.size();
+		if (recordCount > frame.capacity) {
+			uint32_t capacity = std::max(frame.capacity, DefaultGpuCullCapacity);
+			while (capacity < recordCount) {
+				capacity *= 2;
+			}
+			allocateRecords(frame, capacity);
+		}
+
+		if (bucketCount > frame.bucketCapacity) {
+			uint32_t bucketCapacity = std::max(frame.bucketCapacity, DefaultGpuCullBucketCapacity);
+			while (bucketCapacity < bucketCount) {
+				bucketCapacity *= 2;
+			}
+			allocateCounts(frame, bucketCapacity);
+		}
+
+		updateDescriptorSet(frame);
+
+		if (recordCount > 0) {
+			auto data = (uint8_t*)frame.recordBuffer->map();
+			memcpy(data, records.data(), recordCount * sizeof(GpuChunkRecord));
+			frame.recordBuffer->flush(0, recordCount * sizeof(GpuChunkRecord));
+			frame.recordBuffer->unmap();
+		}
+
+		frame.pageCount = pageCount;
+		frame.bucketCount = bucketCount;
+		currentFrame = &frame;
+		return frame;
+	}
+
+	void GpuChunkCuller::draw(VkCommandBuffer commandBuffer, MeshPool& meshPool, RenderStats& stats, MeshPart part, uint32_t pass) const
+	{
+		if (!currentFrame || pass >= currentFrame->passCount) {
+			return;
+		}
+
+		auto indirectBuffer = currentFrame->commandBuffer->getHandle();
+		VkDeviceSize commandStride = sizeof(VkDrawIndexedIndirectCommand);
+		uint32_t firstPassRecord = pass * currentFrame->capacity;
+		uint32_t firstPassCount = pass * currentFrame->bucketCapacity;
+
+		for (uint32_t page = 0; page < currentFrame->pageCount; page++) {
+			uint32_t bucket = (uint32_t)part * currentFrame->pageCount + page;
+			uint32_t firstRecord = bucketFirstRecords[bucket];
+			uint32_t recordCount = bucketRecordCounts[bucket];
+			if (recordCount == 0) {
+				continue;
+			}
+
+			VkBuffer vertexBuffers[] = { meshPool.getVertexBuffer(page).getHandle(), currentFrame->instanceBuffer->getHandle() };
+			VkDeviceSize offsets[] = { 0, 0 };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, meshPool.getIndexBuffer(page).getHandle(), 0, VK_INDEX_TYPE_UINT32);
+
+			if (hasDrawIndirectCount) {
+				vkCmdDrawIndexedIndirectCountKHR(commandBuffer, indirectBuffer, (firstPassRecord + firstRecord) * commandStride, currentFrame->countBuffer->getHandle(), (firstPassCount + bucket) * sizeof(uint32_t), recordCount, (uint32_t)commandStride);
+			}
+			else {
+				vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, (firstPassRecord + firstRecord) * commandStride, recordCount, (uint32_t)commandStride);
+			}
+			stats.drawCalls++;
+		}
+	}
+
+	uint32_t GpuChunkCuller::getRecordCount() const
+	{
+		return (uint32_t)records.size();
+	}
+
+	uint32_t GpuChunkCuller::getLastVisibleCount() const
+	{
+		return lastVisibleCount;
+	}
+
+	bool GpuChunkCuller::isCompacting() const
+	{
+		return hasDrawIndirectCount;
+	}
+
+	GpuCullFrame& GpuChunkCuller::getFrame(uint32_t index)
+	{
+		if (frames.size() <= index) {
+			frames.resize(index + 1);
+		}
+
+		auto& frame = frames[index];
+		if (frame) {
+			return *frame;
+		}
+
+		frame = std::make_unique<GpuCullFrame>();
+
+		std::vector<VkDescriptorPoolSize> poolSizes(2);
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[0].descriptorCount = 9;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[1].descriptorCount = 1;
+		frame->descriptorPool = std::make_unique<DescriptorPool>(device, poolSizes, 2);
+		frame->descriptorSet = frame->descriptorPool->allocate(descriptorSetLayout->getHandle());
+		if (occlusionDescriptorSetLayout) {
+			frame->occlusionDescriptorSet = frame->descriptorPool->allocate(occlusionDescriptorSetLayout->getHandle());
+		}
+
+		VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		allocateInfo.commandPool = commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &frame->computeCommandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot allocate command buffer.");
+		}
+
+		VkSemaphoreCreateInfo semaphoreCreateInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+		if (vkCreateSemaphore(device.getHandle(), &semaphoreCreateInfo, nullptr, &frame->cullFinishedSemaphore) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot create semaphore.");
+		}
+
+		allocateRecords(*frame, DefaultGpuCullCapacity);
+		allocateCounts(*frame, DefaultGpuCullBucketCapacity);
+
+		return *frame;
+	}
+
+	void GpuChunkCuller::readVisibleCount(GpuCullFrame& frame)
+	{
+		if (!frame.isSubmitted) {
+			return;
+		}
+
+		VkDeviceSize size = frame.bucketCount * sizeof(uint32_t);
+		if (size == 0) {
+			lastVisibleCount = 0;
+			return;
+		}
+
+		frame.countBuffer->invalidate(0, VK_WHOLE_SIZE);
+		auto counts = (const uint32_t*)frame.countBuffer->map();
+
+		lastVisibleCount = 0;
+		for (uint32_t pass = 0; pass < frame.passCount; pass++) {
+			for (uint32_t bucket = 0; bucket < frame.bucketCount; bucket++) {
+				lastVisibleCount += counts[pass * frame.bucketCapacity + bucket];
+			}
+		}
+
+		frame.countBuffer->unmap();
+	}
+
+	void GpuChunkCuller::allocateRecords(GpuCullFrame& frame, uint32_t capacity)
+	{
+		std::vector<uint32_t> queueFamilyIndices = { device.getComputeQueueFamilyIndex(), device.getGraphicsQueueFamilyIndex() };
+
+		frame.capacity = capacity;
+		frame.recordBuffer = std::make_unique<VulkanBuffer>(device, capacity * sizeof(GpuChunkRecord), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		frame.commandBuffer = std::make_unique<VulkanBuffer>(device, GpuCullPassCount * capacity * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0, queueFamilyIndices);
+		frame.instanceBuffer = std::make_unique<VulkanBuffer>(device, GpuCullPassCount * capacity * sizeof(glm::vec4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0, queueFamilyIndices);
+		frame.visibilityBuffer = std::make_unique<VulkanBuffer>(device, capacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	}
+
+	void GpuChunkCuller::allocateCounts(GpuCullFrame& frame, uint32_t bucketCapacity)
+	{
+		std::vector<uint32_t> queueFamilyIndices = { device.getComputeQueueFamilyIndex(), device.getGraphicsQueueFamilyIndex() };
+
+		frame.bucketCapacity = bucketCapacity;
+		frame.countBuffer = std::make_unique<VulkanBuffer>(device, GpuCullPassCount * bucketCapacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU, 0, queueFamilyIndices);
+	}
+
+	void GpuChunkCuller::updateDescriptorSet(GpuCullFrame& frame)
+	{
+		VkDescriptorBufferInfo bufferInfos[4]{};
+		bufferInfos[0].buffer = frame.recordBuffer->getHandle();
+		bufferInfos[1].buffer = frame.commandBuffer->getHandle();
+		bufferInfos[2].buffer = frame.instanceBuffer->getHandle();
+		bufferInfos[3].buffer = frame.countBuffer->getHandle();
+
+		VkWriteDescriptorSet writes[4]{};
+		for (uint32_t i = 0; i < 4; i++) {
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range = VK_WHOLE_SIZE;
+
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = frame.descriptorSet;
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo = &bufferInfos[i];
+		}
+
+		vkUpdateDescriptorSets(device.getHandle(), 4, writes, 0, nullptr);
+	}
+
+	void GpuChunkCuller::updateOcclusionDescriptorSet(GpuCullFrame& frame, const DepthPyramid& depthPyramid)
+	{
+		VkDescriptorBufferInfo bufferInfos[5]{};
+		bufferInfos[0].buffer = frame.recordBuffer->getHandle();
+		bufferInfos[1].buffer = frame.commandBuffer->getHandle();
+		bufferInfos[2].buffer = frame.instanceBuffer->getHandle();
+		bufferInfos[3].buffer = frame.countBuffer->getHandle();
+		bufferInfos[4].buffer = frame.visibilityBuffer->getHandle();
+
+		VkWriteDescriptorSet writes[6]{};
+		for (uint32_t i = 0; i < 5; i++) {
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range = VK_WHOLE_SIZE;
+
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = frame.occlusionDescriptorSet;
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo = &bufferInfos[i];
+		}
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.sampler = depthPyramid.getSampler();
+		imageInfo.imageView = depthPyramid.getView();
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		writes[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[5].dstSet = frame.occlusionDescriptorSet;
+		writes[5].dstBinding = 5;
+		writes[5].descriptorCount = 1;
+		writes[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[5].pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(device.getHandle(), 6, writes, 0, nullptr);
+	}
+
+	void GpuChunkCuller::recordCommands(RenderContext& renderContext, GpuCullFrame& frame, const Frustum& frustum)
+	{
+		auto commandBuffer = frame.computeCommandBuffer;
+		vkResetCommandBuffer(commandBuffer, 0);
+
+		VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot begin command buffer.");
+		}
+
+		// The compute submission is waited on by the frame's graphics submission, so it shares the frame's query pool.
+		auto& gpuProfiler = renderContext.getGpuProfiler();
+		auto gpuScope = gpuProfiler.beginScope(commandBuffer, "chunk cull", device.getComputeQueueFamilyIndex());
+
+		vkCmdFillBuffer(commandBuffer, frame.countBuffer->getHandle(), 0, VK_WHOLE_SIZE, 0);
+
+		VkMemoryBarrier clearBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+		GpuCullParameters parameters{};
+		for (uint32_t i = 0; i < 6; i++) {
+			parameters.planes[i] = frustum.getPlane(i);
+		}
+		parameters.recordCount = (uint32_t)records.size();
+		parameters.compact = hasDrawIndirectCount ? 1 : 0;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->getHandle());
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->getLayout(), 0, 1, &frame.descriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipeline->getLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GpuCullParameters), &parameters);
+
+		if (parameters.recordCount > 0) {
+			vkCmdDispatch(commandBuffer, (parameters.recordCount + GpuCullWorkgroupSize - 1) / GpuCullWorkgroupSize, 1, 1);
+		}
+
+		// The per-bucket counts are read back on the host once this frame slot comes around again.
+		VkMemoryBarrier readbackBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		readbackBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &readbackBarrier, 0, nullptr, 0, nullptr);
+		gpuProfiler.endScope(commandBuffer, gpuScope);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot end command buffer.");
+		}
+	}
+
+	void GpuChunkCuller::recordOcclusionPass(RenderContext& renderContext, VkCommandBuffer commandBuffer, const Frustum& frustum, const glm::mat4& occlusionViewProjection, const DepthPyramid& depthPyramid, uint32_t pass, bool isOcclusionEnabled)
+	{
+		GpuOcclusionUniforms uniforms{};
+		for (uint32_t i = 0; i < 6; i++) {
+			uniforms.planes[i] = frustum.getPlane(i);
+		}
+		uniforms.occlusionViewProjection = occlusionViewProjection;
+		uniforms.pyramid = glm::vec4((float)depthPyramid.getWidth(), (float)depthPyramid.getHeight(), (float)depthPyramid.getMipLevels(), isOcclusionEnabled ? 1.0f : 0.0f);
+		auto uniformAllocation = renderContext.getUniformAllocator().push(uniforms);
+
+		GpuOcclusionParameters parameters{};
+		parameters.recordCount = (uint32_t)records.size();
+		parameters.compact = hasDrawIndirectCount ? 1 : 0;
+		parameters.pass = pass;
+		parameters.capacity = currentFrame->capacity;
+		parameters.bucketCapacity = currentFrame->bucketCapacity;
+
+		VkDescriptorSet descriptorSets[] = { currentFrame->occlusionDescriptorSet, uniformAllocation.descriptorSet };
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusionPipeline->getHandle());
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, occlusionPipeline->getLayout(), 0, 2, descriptorSets, 1, &uniformAllocation.offset);
+		vkCmdPushConstants(commandBuffer, occlusionPipeline->getLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GpuOcclusionParameters), &parameters);
+
+		if (parameters.recordCount > 0) {
+			vkCmdDispatch(commandBuffer, (parameters.recordCount + GpuCullWorkgroupSize - 1) / GpuCullWorkgroupSize, 1, 1);
+		}
+	}
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <vk/VulkanBuffer.h>
+#include <vk/DescriptorPool.h>
+#include <vk/DescriptorSetLayout.h>
+#include <rendering/ComputePipeline.h>
+#include <rendering/Frustum.h>
+#include <rendering/DepthPyramid.h>
+#include <rendering/MeshPool.h>
+#include <rendering/Mesh.h>
+#include <rendering/RenderStats.h>
+#include <glm/glm.hpp>
+#include <memory>
+
+namespace vmc
+{
+	class RenderContext;
+
+	const uint32_t DefaultGpuCullCapacity = 1024;
+	const uint32_t DefaultGpuCullBucketCapacity = 16;
+	const uint32_t GpuCullWorkgroupSize = 64;
+	const uint32_t GpuCullPassCount = 2;
+
+	struct GpuChunkRecord
+	{
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		glm::vec4 chunkOffset;
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t bucket;
+		uint32_t outputBase;
+		uint32_t page;
+		uint32_t part;
+		uint32_t padding;
+	};
+
+	struct GpuCullParameters
+	{
+		glm::vec4 planes[6];
+		uint32_t recordCount;
+		uint32_t compact;
+	};
+
+	struct GpuOcclusionUniforms
+	{
+		glm::vec4 planes[6];
+		glm::mat4 occlusionViewProjection;
+		glm::vec4 pyramid;
+	};
+
+	struct GpuOcclusionParameters
+	{
+		uint32_t recordCount;
+		uint32_t compact;
+		uint32_t pass;
+		uint32_t capacity;
+		uint32_t bucketCapacity;
+	};
+
+	struct GpuCullFrame
+	{
+		std::unique_ptr<VulkanBuffer> recordBuffer;
+		std::unique_ptr<VulkanBuffer> commandBuffer;
+		std::unique_ptr<VulkanBuffer> instanceBuffer;
+		std::unique_ptr<VulkanBuffer> countBuffer;
+		std::unique_ptr<VulkanBuffer> visibilityBuffer;
+		std::unique_ptr<DescriptorPool> descriptorPool;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		VkDescriptorSet occlusionDescriptorSet = VK_NULL_HANDLE;
+		VkCommandBuffer computeCommandBuffer = VK_NULL_HANDLE;
+		VkSemaphore cullFinishedSemaphore = VK_NULL_HANDLE;
+		uint32_t capacity = 0;
+		uint32_t bucketCapacity = 0;
+		uint32_t pageCount = 0;
+		uint32_t bucketCount = 0;
+		uint32_t passCount = 0;
+		bool isSubmitted = false;
+	};
+
+	// Frustum-culls chunk bounds on the compute queue and writes the surviving draws into an indirect buffer per bucket, a bucket
+	// being one mesh part of one mesh pool page.
+	// When VK_KHR_draw_indirect_count is available the draws are compacted and the draw count is read from a GPU buffer,
+	// otherwise every record keeps its slot and culled draws are emitted with zero instances.
+	// Occlusion culling runs in two passes on the graphics queue instead: the first draws what the previous depth pyramid
+	// does not hide, the second draws what the pyramid rebuilt from that depth reveals. Each pass owns half of the output buffers.
+	class GpuChunkCuller
+	{
+	public:
+		GpuChunkCuller(const VulkanDevice& device, const DescriptorSetLayout& uniformLayout, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+
+		GpuChunkCuller(const GpuChunkCuller&) = delete;
+
+		GpuChunkCuller(GpuChunkCuller&& other) = delete;
+
+		~GpuChunkCuller();
+
+		GpuChunkCuller& operator=(const GpuChunkCuller&) = delete;
+
+		GpuChunkCuller& operator=(GpuChunkCuller&&) = delete;
+
+		static bool isSupported(const VulkanDevice& device);
+
+		bool isOcclusionSupported() const;
+
+		void reset();
+
+		void add(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& chunkOffset, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t page, MeshPart part);
+
+		void dispatch(RenderContext& renderContext, const Frustum& frustum, uint32_t pageCount);
+
+		void recordOcclusionFirstPass(RenderContext& renderContext, VkCommandBuffer commandBuffer, const Frustum& frustum, const DepthPyramid& depthPyramid, uint32_t pageCount);
+
+		void recordOcclusionSecondPass(RenderContext& renderContext, VkCommandBuffer commandBuffer, const Frustum& frustum, const glm::mat4& viewProjection, const DepthPyramid& depthPyramid);
+
+		void draw(VkCommandBuffer commandBuffer, MeshPool& meshPool, RenderStats& stats, MeshPart part, uint32_t pass = 0) const;
+
+		uint32_t getRecordCount() const;
+
+		uint32_t getLastVisibleCount() const;
+
+		bool isCompacting() const;
+
+	private:
+		const VulkanDevice& device;
+
+		std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
+
+		std::unique_ptr<ComputePipeline> pipeline;
+
+		std::unique_ptr<DescriptorSetLayout> occlusionDescriptorSetLayout;
+
+		std::unique_ptr<ComputePipeline> occlusionPipeline;
+
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+
+		std::vector<std::unique_ptr<GpuCullFrame>> frames;
+
+		GpuCullFrame* currentFrame = nullptr;
+
+		std::vector<GpuChunkRecord> records;
+
+		std::vector<uint32_t> bucketFirstRecords;
+
+		std::vector<uint32_t> bucketRecordCounts;
+
+		uint32_t lastVisibleCount = 0;
+
+		bool hasDrawIndirectCount = false;
+
+		GpuCullFrame& getFrame(uint32_t index);
+
+		GpuCullFrame& prepareFrame(RenderContext& renderContext, uint32_t pageCount);
+
+		void readVisibleCount(GpuCullFrame& frame);
+
+		void allocateRecords(GpuCullFrame& frame, uint32_t capacity);
+
+		void allocateCounts(GpuCullFrame& frame, uint32_t bucketCapacity);
+
+		void updateDescriptorSet(GpuCullFrame& frame);
+
+		void updateOcclusionDescriptorSet(GpuCullFrame& frame, const DepthPyramid& depthPyramid);
+
+		void recordCommands(RenderContext& renderContext, GpuCullFrame& frame, const Frustum& frustum);
+
+		void recordOcclusionPass(RenderContext& renderContext, VkCommandBuffer commandBuffer, const Frustum& frustum, const glm::mat4& occlusionViewProjection, const DepthPyramid& depthPyramid, uint32_t pass, bool isOcclusionEnabled);
+	};
+}
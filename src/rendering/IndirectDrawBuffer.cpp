@@ -0,0 +1,104 @@
+#include "IndirectDrawBuffer.h"
+#include <cstring>
+#include <vector>
+
+namespace vmc
+{
+    IndirectDrawBuffer::IndirectDrawBuffer(const VulkanDevice& device, uint32_t capacity) :
+        device(device)
+    {
+        allocate(capacity);
+    }
+
+    IndirectDrawBuffer::~IndirectDrawBuffer()
+    {
+        release();
+    }
+
+    void IndirectDrawBuffer::reset()
+    {
+        drawCount = 0;
+    }
+
+    uint32_t IndirectDrawBuffer::add(uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset, const glm::vec4& instanceData)
+    {
+        if (drawCount == capacity) {
+            // Growing is only done while recording, after the fence of this frame slot was waited on, so the old buffers are idle.
+            std::vector<VkDrawIndexedIndirectCommand> oldCommands(commands, commands + drawCount);
+            std::vector<glm::vec4> oldInstances(instances, instances + drawCount);
+
+            release();
+            allocate(capacity * 2);
+
+            memcpy(commands, oldCommands.data(), oldCommands.size() * sizeof(VkDrawIndexedIndirectCommand));
+            memcpy(instances, oldInstances.data(), oldInstances.size() * sizeof(glm::vec4));
+        }
+
+        uint32_t index = drawCount++;
+
+        auto& command = commands[index];
+        command.indexCount = indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = firstIndex;
+        command.vertexOffset = vertexOffset;
+        command.firstInstance = index;
+
+        instances[index] = instanceData;
+
+        return index;
+    }
+
+    void IndirectDrawBuffer::flush()
+    {
+        if (drawCount == 0) {
+            return;
+        }
+
+        commandBuffer->flush(0, drawCount * sizeof(VkDrawIndexedIndirectCommand));
+        instanceBuffer->flush(0, drawCount * sizeof(glm::vec4));
+    }
+
+    uint32_t IndirectDrawBuffer::getDrawCount() const
+    {
+        return drawCount;
+    }
+
+    const VkDrawIndexedIndirectCommand& IndirectDrawBuffer::getCommand(uint32_t index) const
+    {
+        return commands[index];
+    }
+
+    const VulkanBuffer& IndirectDrawBuffer::getCommandBuffer() const
+    {
+        return *commandBuffer;
+    }
+
+    const VulkanBuffer& IndirectDrawBuffer::getInstanceBuffer() const
+    {
+        return *instanceBuffer;
+    }
+
+    void IndirectDrawBuffer::allocate(uint32_t newCapacity)
+    {
+        capacity = newCapacity;
+
+        commandBuffer = std::make_unique<VulkanBuffer>(device, capacity * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        instanceBuffer = std::make_unique<VulkanBuffer>(device, capacity * sizeof(glm::vec4), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+        commands = (VkDrawIndexedIndirectCommand*)commandBuffer->map();
+        instances = (glm::vec4*)instanceBuffer->map();
+    }
+
+    void IndirectDrawBuffer::release()
+    {
+        if (commandBuffer) {
+            commandBuffer->unmap();
+            commandBuffer.reset();
+        }
+
+        if (instanceBuffer) {
+            instanceBuffer->unmap();
+            instanceBuffer.reset();
+        }
+    }
+}
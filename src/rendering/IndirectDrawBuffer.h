@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vk/VulkanBuffer.h>
+#include <glm/glm.hpp>
+#include <memory>
+
+namespace vmc
+{
+    const uint32_t DefaultIndirectDrawCapacity = 1024;
+
+    class IndirectDrawBuffer
+    {
+    public:
+        IndirectDrawBuffer(const VulkanDevice& device, uint32_t capacity = DefaultIndirectDrawCapacity);
+
+        IndirectDrawBuffer(const IndirectDrawBuffer&) = delete;
+
+        IndirectDrawBuffer(IndirectDrawBuffer&& other) = delete;
+
+        ~IndirectDrawBuffer();
+
+        IndirectDrawBuffer& operator=(const IndirectDrawBuffer&) = delete;
+
+        IndirectDrawBuffer& operator=(IndirectDrawBuffer&&) = delete;
+
+        void reset();
+
+        uint32_t add(uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset, const glm::vec4& instanceData);
+
+        void flush();
+
+        uint32_t getDrawCount() const;
+
+        const VkDrawIndexedIndirectCommand& getCommand(uint32_t index) const;
+
+        const VulkanBuffer& getCommandBuffer() const;
+
+        const VulkanBuffer& getInstanceBuffer() const;
+
+    private:
+        const VulkanDevice& device;
+
+        uint32_t capacity = 0;
+
+        uint32_t drawCount = 0;
+
+        std::unique_ptr<VulkanBuffer> commandBuffer;
+
+        std::unique_ptr<VulkanBuffer> instanceBuffer;
+
+        VkDrawIndexedIndirectCommand* commands = nullptr;
+
+        glm::vec4* instances = nullptr;
+
+        void allocate(uint32_t newCapacity);
+
+        void release();
+    };
+}
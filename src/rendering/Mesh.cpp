@@ -2,32 +2,84 @@
 
 namespace vmc
 {
-    Mesh::Mesh(VulkanBuffer&& vertexBuffer, VulkanBuffer&& indexBuffer, uint32_t indicesCount) :
-        vertexBuffer(std::move(vertexBuffer)),
-        indexBuffer(std::move(indexBuffer)),
-        indicesCount(indicesCount)
+    Mesh::Mesh(MeshPool& pool, const MeshAllocation& allocation, const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint32_t opaqueIndexCount) :
+        pool(&pool),
+        allocation(allocation),
+        boundsMin(boundsMin),
+        boundsMax(boundsMax),
+        opaqueIndexCount(opaqueIndexCount)
     {
     }
 
     Mesh::Mesh(Mesh&& other) noexcept :
-        vertexBuffer(std::move(other.vertexBuffer)),
-        indexBuffer(std::move(other.indexBuffer)),
-        indicesCount(other.indicesCount)
+        pool(other.pool),
+        allocation(other.allocation),
+        boundsMin(other.boundsMin),
+        boundsMax(other.boundsMax),
+        opaqueIndexCount(other.opaqueIndexCount)
     {
+        other.pool = nullptr;
+    }
+
+    Mesh::~Mesh()
+    {
+        if (pool != nullptr) {
+            pool->free(allocation);
+        }
     }
 
     const VulkanBuffer& Mesh::getVertexBuffer() const
     {
-        return vertexBuffer;
+        return pool->getVertexBuffer(allocation.page);
     }
 
     const VulkanBuffer& Mesh::getIndexBuffer() const
     {
-        return indexBuffer;
+        return pool->getIndexBuffer(allocation.page);
+    }
+
+    uint32_t Mesh::getPage() const
+    {
+        return allocation.page;
+    }
+
+    uint32_t Mesh::getVertexOffset() const
+    {
+        return allocation.vertexOffset;
+    }
+
+    uint32_t Mesh::getFirstIndex() const
+    {
+        return allocation.indexOffset;
     }
 
     uint32_t Mesh::getIndicesCount() const
     {
-        return indicesCount;
+        return allocation.indexCount;
+    }
+
+    uint32_t Mesh::getFirstIndex(MeshPart part) const
+    {
+        return part == MeshPart::Opaque ? allocation.indexOffset : allocation.indexOffset + opaqueIndexCount;
+    }
+
+    uint32_t Mesh::getIndicesCount(MeshPart part) const
+    {
+        return part == MeshPart::Opaque ? opaqueIndexCount : allocation.indexCount - opaqueIndexCount;
+    }
+
+    VkDeviceSize Mesh::getSize() const
+    {
+        return (VkDeviceSize)allocation.vertexCount * pool->getVertexStride() + (VkDeviceSize)allocation.indexCount * sizeof(uint32_t);
+    }
+
+    const glm::vec3& Mesh::getBoundsMin() const
+    {
+        return boundsMin;
+    }
+
+    const glm::vec3& Mesh::getBoundsMax() const
+    {
+        return boundsMax;
     }
-}
\ No newline at end of file
+}
@@ -1,19 +1,30 @@
 #pragma once
 
-#include <vk/VulkanBuffer.h>
+#include <rendering/MeshPool.h>
+#include <glm/glm.hpp>
 
 namespace vmc
 {
+    // Opaque geometry is drawn first without alpha testing so that early depth tests stay effective, cutout geometry such as
+    // vegetation follows with discard and without face culling.
+    enum class MeshPart
+    {
+        Opaque,
+        Cutout
+    };
+
+    constexpr uint32_t MeshPartCount = 2;
+
     class Mesh
     {
     public:
-        Mesh(VulkanBuffer&& vertexBuffer, VulkanBuffer&& indexBuffer, uint32_t indicesCount);
+        Mesh(MeshPool& pool, const MeshAllocation& allocation, const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint32_t opaqueIndexCount);
 
         Mesh(const Mesh&) = delete;
 
         Mesh(Mesh&& other) noexcept;
 
-        ~Mesh() = default;
+        ~Mesh();
 
         Mesh& operator=(const Mesh&) = delete;
 
@@ -23,13 +34,34 @@ namespace vmc
 
         const VulkanBuffer& getIndexBuffer() const;
 
+        uint32_t getPage() const;
+
+        uint32_t getVertexOffset() const;
+
+        uint32_t getFirstIndex() const;
+
         uint32_t getIndicesCount() const;
 
+        uint32_t getFirstIndex(MeshPart part) const;
+
+        uint32_t getIndicesCount(MeshPart part) const;
+
+        // Bytes of this mesh's vertices and indices, the buffers themselves are pool pages shared with other meshes.
+        VkDeviceSize getSize() const;
+
+        const glm::vec3& getBoundsMin() const;
+
+        const glm::vec3& getBoundsMax() const;
+
     private:
-        uint32_t indicesCount = 0;
+        MeshPool* pool;
+
+        MeshAllocation allocation;
+
+        glm::vec3 boundsMin;
 
-        VulkanBuffer vertexBuffer;
+        glm::vec3 boundsMax;
 
-        VulkanBuffer indexBuffer;
+        uint32_t opaqueIndexCount;
     };
-}
\ No newline at end of file
+}
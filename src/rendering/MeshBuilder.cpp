@@ -1,6 +1,6 @@
 #include "MeshBuilder.h"
-#include <chrono>
-#include <common/Log.h>
+#include <algorithm>
+#include <common/Profiler.h>
 
 namespace vmc
 {
@@ -103,21 +103,23 @@ namespace vmc
         }
     }
 
-    MeshBuilder::MeshBuilder(const VulkanDevice& device, const std::vector<Block>& blockDescriptions) :
+    MeshBuilder::MeshBuilder(const VulkanDevice& device, MeshPool& meshPool, const std::vector<Block>& blockDescriptions) :
         blockDescriptions(blockDescriptions),
-        device(device)
+        device(device),
+        meshPool(meshPool)
     {
     }
 
     Mesh MeshBuilder::buildChunkMesh(StagingManager& stagingManager, const World& world, const Chunk& chunk, const glm::ivec2& chunkCoordinate) const
     {
-        auto start = std::chrono::high_resolution_clock::now();
+        VMC_PROFILE_ZONE("build chunk mesh");
 
         static std::vector<uint8_t> visibleChunkFaces(ChunkHeight * ChunkWidth * ChunkLength, 0);
         memset(visibleChunkFaces.data(), 0, visibleChunkFaces.size());
 
         std::vector<BlockVertex> vertices;
         std::vector<uint32_t> indices;
+        std::vector<uint32_t> cutoutIndices;
 
         for (uint32_t y = 0; y <= chunk.getMaxHeight() + 1; y++) {
             for (uint32_t z = 0; z < ChunkLength; z++) {
@@ -145,21 +147,21 @@ namespace vmc
                         auto blockId = chunkData[index];
                         const auto& description = blockDescriptions[blockId];
                         if (description.shape == BlockShape::Cube) {
-                            addCube(vertices, indices, description, { x, y, z }, visibleFaces);
+                            addCube(vertices, description.isOpaque ? indices : cutoutIndices, description, { x, y, z }, visibleFaces);
                         }
                         else {
-                            addCross(vertices, indices, description, { x, y, z }, visibleFaces);
+                            addCross(vertices, cutoutIndices, description, { x, y, z }, visibleFaces);
                         }
                     }
                 }
             }
         }
 
-        auto end = std::chrono::high_resolution_clock::now();
+        // Both parts share one allocation, the cutout indices follow the opaque ones.
+        uint32_t opaqueIndexCount = indices.size();
+        indices.insert(indices.end(), cutoutIndices.begin(), cutoutIndices.end());
 
-        //logd("Chunk rebuild time: %u ms.", std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
-
-        return createMesh(stagingManager, vertices, indices);
+        return createMesh(stagingManager, vertices, indices, opaqueIndexCount);
     }
 
     Mesh MeshBuilder::buildBlockMesh(StagingManager& stagingManager, BlockId blockId) const
@@ -167,9 +169,10 @@ namespace vmc
         std::vector<BlockVertex> vertices;
         std::vector<uint32_t> indices;
 
-        addCube(vertices, indices, blockDescriptions[blockId], { 0, 0, 0 }, Faces::All);
+        const auto& description = blockDescriptions[blockId];
+        addCube(vertices, indices, description, { 0, 0, 0 }, Faces::All);
 
-        return createMesh(stagingManager, vertices, indices);
+        return createMesh(stagingManager, vertices, indices, description.isOpaque ? indices.size() : 0);
     }
 
     void MeshBuilder::addAdjascent(const glm::ivec3& position, const Chunk& chunk, std::vector<uint8_t>& chunkFaces) const
@@ -242,15 +245,134 @@ namespace vmc
         chunkFaces[index] = faces;
     }
 
-    Mesh MeshBuilder::createMesh(StagingManager& stagingManager, const std::vector<BlockVertex>& vertices, const std::vector<uint32_t>& indices) const
+    Mesh MeshBuilder::createMesh(StagingManager& stagingManager, const std::vector<BlockVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t opaqueIndexCount) const
+    {
+        auto allocation = meshPool.allocate(vertices.size(), indices.size());
+        if (allocation.indexCount > 0) {
+            VkDeviceSize vertexStride = meshPool.getVertexStride();
+            stagingManager.copyToBuffer(vertices.data(), meshPool.getVertexBuffer(allocation.page), allocation.vertexOffset * vertexStride, vertices.size() * vertexStride);
+            stagingManager.copyToBuffer(indices.data(), meshPool.getIndexBuffer(allocation.page), allocation.indexOffset * sizeof(uint32_t), indices.size() * sizeof(uint32_t));
+        }
+
+        glm::vec3 boundsMin(0.0f);
+        glm::vec3 boundsMax(0.0f);
+        if (!vertices.empty()) {
+            boundsMin = glm::vec3(vertices[0].position);
+            boundsMax = boundsMin;
+            for (const auto& vertex : vertices) {
+                boundsMin = glm::min(boundsMin, glm::vec3(vertex.position));
+                boundsMax = glm::max(boundsMax, glm::vec3(vertex.position));
+            }
+        }
+
+        return Mesh(meshPool, allocation, boundsMin, boundsMax, opaqueIndexCount);
+    }
+
+    ChunkConnectivity MeshBuilder::buildChunkConnectivity(const Chunk& chunk) const
+    {
+        VMC_PROFILE_ZONE("build chunk connectivity");
+        ChunkConnectivity connectivity;
+
+        for (uint32_t section = 0; section < SectionsPerChunk; section++) {
+            uint32_t baseY = section * SectionSize;
+            if (baseY > chunk.getMaxHeight()) {
+                connectivity.sections[section].connectAll();
+                continue;
+            }
+
+            // A section is a contiguous run of blocks, since chunk data is laid out in horizontal layers.
+            buildSectionConnectivity(chunk.getData() + getIndexInChunk(0, baseY, 0), connectivity.sections[section]);
+        }
+
+        return connectivity;
+    }
+
+    ChunkOccluder MeshBuilder::buildChunkOccluder(const Chunk& chunk) const
+    {
+        VMC_PROFILE_ZONE("build chunk occluder");
+        ChunkOccluder occluder;
+
+        for (uint32_t cellZ = 0; cellZ < OccluderCellsPerSide; cellZ++) {
+            for (uint32_t cellX = 0; cellX < OccluderCellsPerSide; cellX++) {
+                uint32_t cellHeight = chunk.getMaxHeight() + 1;
+
+                // The slab of a cell ends at the lowest gap in any of its columns.
+                for (uint32_t z = cellZ * OccluderCellSize; z < (cellZ + 1) * OccluderCellSize; z++) {
+                    for (uint32_t x = cellX * OccluderCellSize; x < (cellX + 1) * OccluderCellSize; x++) {
+                        uint32_t y = 0;
+                        while (y < cellHeight && isOpaque(chunk.getBlock(x, y, z))) {
+                            y++;
+                        }
+                        cellHeight = y;
+                    }
+                }
+
+                occluder.cellHeights[cellZ * OccluderCellsPerSide + cellX] = (uint16_t)std::min(cellHeight, ChunkHeight);
+            }
+        }
+
+        return occluder;
+    }
+
+    void MeshBuilder::buildSectionConnectivity(const BlockId* sectionBlocks, SectionConnectivity& connectivity) const
     {
-        VulkanBuffer vertexBuffer(device, vertices.size() * sizeof(BlockVertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
-        VulkanBuffer indexBuffer(device, indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+        const uint32_t sectionVolume = SectionSize * SectionSize * SectionSize;
+
+        static std::vector<uint8_t> visited(sectionVolume);
+        static std::vector<uint16_t> stack;
+
+        uint32_t opaqueCount = 0;
+        for (uint32_t i = 0; i < sectionVolume; i++) {
+            visited[i] = isOpaque(sectionBlocks[i]) ? 1 : 0;
+            opaqueCount += visited[i];
+        }
+
+        if (opaqueCount == 0) {
+            connectivity.connectAll();
+            return;
+        }
+
+        for (uint32_t i = 0; i < sectionVolume; i++) {
+            if (visited[i]) {
+                continue;
+            }
 
-        stagingManager.copyToBuffer(vertices.data(), vertexBuffer, 0, vertexBuffer.getSize());
-        stagingManager.copyToBuffer(indices.data(), indexBuffer, 0, indexBuffer.getSize());
+            // Flood fill one pocket of non-opaque blocks and connect every pair of section faces it touches.
+            uint32_t touchedFaces = 0;
+            visited[i] = 1;
+            stack.push_back((uint16_t)i);
 
-        return Mesh(std::move(vertexBuffer), std::move(indexBuffer), indices.size());
+            while (!stack.empty()) {
+                uint32_t index = stack.back();
+                stack.pop_back();
+
+                glm::ivec3 position(index % SectionSize, index / (SectionSize * SectionSize), (index / SectionSize) % SectionSize);
+
+                for (uint32_t face = 0; face < SectionFaceCount; face++) {
+                    auto neighbour = position + SectionFaceDirections[face];
+                    if (neighbour.x < 0 || neighbour.x >= (int32_t)SectionSize ||
+                        neighbour.y < 0 || neighbour.y >= (int32_t)SectionSize ||
+                        neighbour.z < 0 || neighbour.z >= (int32_t)SectionSize) {
+                        touchedFaces |= 1 << face;
+                        continue;
+                    }
+
+                    uint32_t neighbourIndex = (neighbour.y * SectionSize + neighbour.z) * SectionSize + neighbour.x;
+                    if (!visited[neighbourIndex]) {
+                        visited[neighbourIndex] = 1;
+                        stack.push_back((uint16_t)neighbourIndex);
+                    }
+                }
+            }
+
+            for (uint32_t from = 0; from < SectionFaceCount; from++) {
+                for (uint32_t to = from + 1; to < SectionFaceCount; to++) {
+                    if ((touchedFaces & (1 << from)) && (touchedFaces & (1 << to))) {
+                        connectivity.connect(from, to);
+                    }
+                }
+            }
+        }
     }
 
     bool MeshBuilder::isOpaque(BlockId id) const
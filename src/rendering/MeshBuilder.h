@@ -4,6 +4,8 @@
 #include <memory>
 #include <string>
 #include <world/World.h>
+#include <rendering/CaveCuller.h>
+#include <rendering/OcclusionRasterizer.h>
 
 namespace vmc
 {
@@ -28,7 +30,7 @@ namespace vmc
     class MeshBuilder
     {
     public:
-        MeshBuilder(const VulkanDevice& device, const std::vector<Block>& blockDescriptions);
+        MeshBuilder(const VulkanDevice& device, MeshPool& meshPool, const std::vector<Block>& blockDescriptions);
 
         MeshBuilder(const MeshBuilder&) = delete;
 
@@ -42,18 +44,26 @@ namespace vmc
 
         Mesh buildBlockMesh(StagingManager& stagingManager, BlockId blockId) const;
 
+        ChunkConnectivity buildChunkConnectivity(const Chunk& chunk) const;
+
+        ChunkOccluder buildChunkOccluder(const Chunk& chunk) const;
+
     private:
         const VulkanDevice& device;
 
+        MeshPool& meshPool;
+
         const std::vector<Block>& blockDescriptions;
 
         void addAdjascent(const glm::ivec3& position, const Chunk& chunk, std::vector<uint8_t>& chunkFaces) const;
 
         void addBoundaryBlock(const glm::ivec3& position, const World& world, const Chunk& chunk, std::vector<uint8_t>& chunkFaces, const glm::ivec2& chunkCoordinate) const;
 
+        void buildSectionConnectivity(const BlockId* sectionBlocks, SectionConnectivity& connectivity) const;
+
         void addTransparentBlock(const glm::ivec3& position, const Chunk& chunk, std::vector<uint8_t>& chunkFaces) const;
 
-        Mesh createMesh(StagingManager& stagingManager, const std::vector<BlockVertex>& vertices, const std::vector<uint32_t>& indices) const;
+        Mesh createMesh(StagingManager& stagingManager, const std::vector<BlockVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t opaqueIndexCount) const;
 
         bool isOpaque(BlockId id) const;
     };
@@ -0,0 +1,180 @@
+#include "MeshPool.h"
+#include <algorithm>
+
+namespace vmc
+{
+    RangeAllocator::RangeAllocator(uint32_t size) :
+        size(size),
+        freeSize(size)
+    {
+        freeRanges.emplace(0, size);
+    }
+
+    bool RangeAllocator::allocate(uint32_t size, uint32_t& offset)
+    {
+        if (size == 0) {
+            offset = 0;
+            return true;
+        }
+
+        for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+            if (it->second < size) {
+                continue;
+            }
+
+            offset = it->first;
+            uint32_t remainingSize = it->second - size;
+            freeRanges.erase(it);
+
+            if (remainingSize > 0) {
+                freeRanges.emplace(offset + size, remainingSize);
+            }
+
+            freeSize -= size;
+            return true;
+        }
+
+        return false;
+    }
+
+    void RangeAllocator::free(uint32_t offset, uint32_t size)
+    {
+        if (size == 0) {
+            return;
+        }
+
+        freeSize += size;
+
+        auto next = freeRanges.lower_bound(offset);
+        if (next != freeRanges.end() && offset + size == next->first) {
+            size += next->second;
+            next = freeRanges.erase(next);
+        }
+
+        if (next != freeRanges.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset) {
+                previous->second += size;
+                return;
+            }
+        }
+
+        freeRanges.emplace(offset, size);
+    }
+
+    uint32_t RangeAllocator::getSize() const
+    {
+        return size;
+    }
+
+    uint32_t RangeAllocator::getFreeSize() const
+    {
+        return freeSize;
+    }
+
+    MeshPool::MeshPool(const VulkanDevice& device, uint32_t vertexStride, uint32_t pageVertexCount, uint32_t pageIndexCount) :
+        device(device),
+        vertexStride(vertexStride),
+        pageVertexCount(pageVertexCount),
+        pageIndexCount(pageIndexCount)
+    {
+    }
+
+    MeshAllocation MeshPool::allocate(uint32_t vertexCount, uint32_t indexCount)
+    {
+        MeshAllocation allocation;
+        allocation.vertexCount = vertexCount;
+        allocation.indexCount = indexCount;
+
+        if (vertexCount == 0 || indexCount == 0) {
+            allocation.vertexCount = 0;
+            allocation.indexCount = 0;
+            return allocation;
+        }
+
+        for (uint32_t i = 0; i < pages.size(); i++) {
+            auto& page = *pages[i];
+            if (page.vertexRanges.getFreeSize() < vertexCount || page.indexRanges.getFreeSize() < indexCount) {
+                continue;
+            }
+
+            if (!page.vertexRanges.allocate(vertexCount, allocation.vertexOffset)) {
+                continue;
+            }
+
+            if (!page.indexRanges.allocate(indexCount, allocation.indexOffset)) {
+                page.vertexRanges.free(allocation.vertexOffset, vertexCount);
+                continue;
+            }
+
+            allocation.page = i;
+            return allocation;
+        }
+
+        auto& page = createPage(std::max(vertexCount, pageVertexCount), std::max(indexCount, pageIndexCount));
+        page.vertexRanges.allocate(vertexCount, allocation.vertexOffset);
+        page.indexRanges.allocate(indexCount, allocation.indexOffset);
+        allocation.page = (uint32_t)pages.size() - 1;
+
+        return allocation;
+    }
+
+    void MeshPool::free(const MeshAllocation& allocation)
+    {
+        if (allocation.indexCount == 0) {
+            return;
+        }
+
+        auto& page = *pages[allocation.page];
+        page.vertexRanges.free(allocation.vertexOffset, allocation.vertexCount);
+        page.indexRanges.free(allocation.indexOffset, allocation.indexCount);
+    }
+
+    VulkanBuffer& MeshPool::getVertexBuffer(uint32_t page)
+    {
+        return pages[page]->vertexBuffer;
+    }
+
+    VulkanBuffer& MeshPool::getIndexBuffer(uint32_t page)
+    {
+        return pages[page]->indexBuffer;
+    }
+
+    uint32_t MeshPool::getPageCount() const
+    {
+        return (uint32_t)pages.size();
+    }
+
+    uint32_t MeshPool::getVertexStride() const
+    {
+        return vertexStride;
+    }
+
+    MeshPoolStats MeshPool::getStats() const
+    {
+        MeshPoolStats stats;
+        for (const auto& page : pages) {
+            uint32_t vertexCount = page->vertexRanges.getSize() - page->vertexRanges.getFreeSize();
+            uint32_t indexCount = page->indexRanges.getSize() - page->indexRanges.getFreeSize();
+
+            stats.vertexCount += vertexCount;
+            stats.indexCount += indexCount;
+            stats.usedBytes += (VkDeviceSize)vertexCount * vertexStride + (VkDeviceSize)indexCount * sizeof(uint32_t);
+            stats.allocatedBytes += page->vertexBuffer.getSize() + page->indexBuffer.getSize();
+        }
+
+        return stats;
+    }
+
+    MeshPoolPage& MeshPool::createPage(uint32_t vertexCount, uint32_t indexCount)
+    {
+        pages.push_back(std::make_unique<MeshPoolPage>(MeshPoolPage{
+            VulkanBuffer(device, (VkDeviceSize)vertexCount * vertexStride, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY),
+            VulkanBuffer(device, (VkDeviceSize)indexCount * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY),
+            RangeAllocator(vertexCount),
+            RangeAllocator(indexCount)
+        }));
+
+        return *pages.back();
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vk/VulkanBuffer.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace vmc
+{
+    const uint32_t DefaultMeshPoolPageVertexCount = 2 * 1024 * 1024;
+    const uint32_t DefaultMeshPoolPageIndexCount = 3 * 1024 * 1024;
+
+    struct MeshAllocation
+    {
+        uint32_t page = 0;
+        uint32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexOffset = 0;
+        uint32_t indexCount = 0;
+    };
+
+    class RangeAllocator
+    {
+    public:
+        RangeAllocator(uint32_t size);
+
+        bool allocate(uint32_t size, uint32_t& offset);
+
+        void free(uint32_t offset, uint32_t size);
+
+        uint32_t getSize() const;
+
+        uint32_t getFreeSize() const;
+
+    private:
+        uint32_t size;
+
+        uint32_t freeSize;
+
+        std::map<uint32_t, uint32_t> freeRanges;
+    };
+
+    struct MeshPoolStats
+    {
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        VkDeviceSize usedBytes = 0;
+        VkDeviceSize allocatedBytes = 0;
+    };
+
+    struct MeshPoolPage
+    {
+        VulkanBuffer vertexBuffer;
+        VulkanBuffer indexBuffer;
+        RangeAllocator vertexRanges;
+        RangeAllocator indexRanges;
+    };
+
+    class MeshPool
+    {
+    public:
+        MeshPool(const VulkanDevice& device, uint32_t vertexStride, uint32_t pageVertexCount = DefaultMeshPoolPageVertexCount, uint32_t pageIndexCount = DefaultMeshPoolPageIndexCount);
+
+        MeshPool(const MeshPool&) = delete;
+
+        MeshPool(MeshPool&& other) = delete;
+
+        ~MeshPool() = default;
+
+        MeshPool& operator=(const MeshPool&) = delete;
+
+        MeshPool& operator=(MeshPool&&) = delete;
+
+        MeshAllocation allocate(uint32_t vertexCount, uint32_t indexCount);
+
+        void free(const MeshAllocation& allocation);
+
+        VulkanBuffer& getVertexBuffer(uint32_t page);
+
+        VulkanBuffer& getIndexBuffer(uint32_t page);
+
+        uint32_t getPageCount() const;
+
+        uint32_t getVertexStride() const;
+
+        MeshPoolStats getStats() const;
+
+    private:
+        const VulkanDevice& device;
+
+        uint32_t vertexStride;
+
+        uint32_t pageVertexCount;
+
+        uint32_t pageIndexCount;
+
+        std::vector<std::unique_ptr<MeshPoolPage>> pages;
+
+        MeshPoolPage& createPage(uint32_t vertexCount, uint32_t indexCount);
+    };
+}
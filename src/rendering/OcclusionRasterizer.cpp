@@ -0,0 +1,231 @@
+#include "OcclusionRasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace vmc
+{
+    // Corners closer than this to the eye plane cannot be projected reliably.
+    const float OcclusionMinW = 1e-3f;
+
+    // Occluders are shrunk slightly so that they never hide a box they are contained in, such as their own chunk.
+    const float OccluderInset = 1e-2f;
+
+    OcclusionRasterizer::OcclusionRasterizer(uint32_t width, uint32_t height) :
+        width(width),
+        height(height),
+        depth(width * height, 0.0f),
+        viewProjection(1.0f),
+        cameraPosition(0.0f)
+    {
+    }
+
+    void OcclusionRasterizer::clear(const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+    {
+        this->viewProjection = viewProjection;
+        this->cameraPosition = cameraPosition;
+        std::fill(depth.begin(), depth.end(), 0.0f);
+        stats = OcclusionRasterizerStats();
+    }
+
+    void OcclusionRasterizer::addOccluder(const glm::vec3& min, const glm::vec3& max)
+    {
+        glm::vec3 a = min + OccluderInset;
+        glm::vec3 b = max - OccluderInset;
+        if (a.x >= b.x || a.y >= b.y || a.z >= b.z) {
+            return;
+        }
+
+        // A box the camera stands in would hide everything.
+        if (cameraPosition.x > a.x && cameraPosition.y > a.y && cameraPosition.z > a.z &&
+            cameraPosition.x < b.x && cameraPosition.y < b.y && cameraPosition.z < b.z) {
+            return;
+        }
+
+        stats.occluderBoxes++;
+
+        // The box is solid, so only the faces turned towards the camera contribute to the depth buffer.
+        if (cameraPosition.x < a.x) {
+            rasterizeQuad({ a.x, a.y, a.z }, { a.x, b.y, a.z }, { a.x, b.y, b.z }, { a.x, a.y, b.z });
+        }
+        else if (cameraPosition.x > b.x) {
+            rasterizeQuad({ b.x, a.y, a.z }, { b.x, b.y, a.z }, { b.x, b.y, b.z }, { b.x, a.y, b.z });
+        }
+
+        if (cameraPosition.y < a.y) {
+            rasterizeQuad({ a.x, a.y, a.z }, { b.x, a.y, a.z }, { b.x, a.y, b.z }, { a.x, a.y, b.z });
+        }
+        else if (cameraPosition.y > b.y) {
+            rasterizeQuad({ a.x, b.y, a.z }, { b.x, b.y, a.z }, { b.x, b.y, b.z }, { a.x, b.y, b.z });
+        }
+
+        if (cameraPosition.z < a.z) {
+            rasterizeQuad({ a.x, a.y, a.z }, { b.x, a.y, a.z }, { b.x, b.y, a.z }, { a.x, b.y, a.z });
+        }
+        else if (cameraPosition.z > b.z) {
+            rasterizeQuad({ a.x, a.y, b.z }, { b.x, a.y, b.z }, { b.x, b.y, b.z }, { a.x, b.y, b.z });
+        }
+    }
+
+    void OcclusionRasterizer::addChunkOccluder(const glm::ivec2& coord, const ChunkOccluder& occluder)
+    {
+        glm::vec3 chunkOffset(coord[0] * (int32_t)ChunkWidth, 0, coord[1] * (int32_t)ChunkLength);
+
+        for (uint32_t z = 0; z < OccluderCellsPerSide; z++) {
+            // Neighbouring cells of equal height along a row are merged into one box.
+            uint32_t x = 0;
+            while (x < OccluderCellsPerSide) {
+                uint16_t cellHeight = occluder.cellHeights[z * OccluderCellsPerSide + x];
+                uint32_t end = x + 1;
+                while (end < OccluderCellsPerSide && occluder.cellHeights[z * OccluderCellsPerSide + end] == cellHeight) {
+                    end++;
+                }
+
+                if (cellHeight > 0) {
+                    glm::vec3 min = chunkOffset + glm::vec3(x * OccluderCellSize, 0, z * OccluderCellSize);
+                    glm::vec3 max = chunkOffset + glm::vec3(end * OccluderCellSize, cellHeight, (z + 1) * OccluderCellSize);
+                    addOccluder(min, max);
+                }
+
+                x = end;
+            }
+        }
+    }
+
+    bool OcclusionRasterizer::isBoxVisible(const glm::vec3& min, const glm::vec3& max)
+    {
+        stats.testedBoxes++;
+
+        float minX = (float)width;
+        float minY = (float)height;
+        float maxX = 0.0f;
+        float maxY = 0.0f;
+        float nearestInvW = 0.0f;
+
+        for (uint32_t i = 0; i < 8; i++) {
+            glm::vec3 corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+
+            ScreenVertex vertex;
+            if (!project(corner, vertex)) {
+                return true;
+            }
+
+            minX = std::min(minX, vertex.x);
+            minY = std::min(minY, vertex.y);
+            maxX = std::max(maxX, vertex.x);
+            maxY = std::max(maxY, vertex.y);
+            nearestInvW = std::max(nearestInvW, vertex.invW);
+        }
+
+        int32_t beginX = std::max((int32_t)std::floor(minX), 0);
+        int32_t beginY = std::max((int32_t)std::floor(minY), 0);
+        int32_t endX = std::min((int32_t)std::floor(maxX), (int32_t)width - 1);
+        int32_t endY = std::min((int32_t)std::floor(maxY), (int32_t)height - 1);
+        if (beginX > endX || beginY > endY) {
+            return true;
+        }
+
+        for (int32_t y = beginY; y <= endY; y++) {
+            const float* row = depth.data() + y * width;
+
+            uint32_t hidden = 1;
+            for (int32_t x = beginX; x <= endX; x++) {
+                hidden &= (uint32_t)(row[x] > nearestInvW);
+            }
+
+            if (!hidden) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint32_t OcclusionRasterizer::getWidth() const
+    {
+        return width;
+    }
+
+    uint32_t OcclusionRasterizer::getHeight() const
+    {
+        return height;
+    }
+
+    const OcclusionRasterizerStats& OcclusionRasterizer::getStats() const
+    {
+        return stats;
+    }
+
+    bool OcclusionRasterizer::project(const glm::vec3& position, ScreenVertex& vertex) const
+    {
+        glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+        if (clip.w <= OcclusionMinW) {
+            return false;
+        }
+
+        float invW = 1.0f / clip.w;
+        vertex.x = (clip.x * invW * 0.5f + 0.5f) * width;
+        vertex.y = (clip.y * invW * 0.5f + 0.5f) * height;
+        vertex.invW = invW;
+        return true;
+    }
+
+    void OcclusionRasterizer::rasterizeQuad(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d)
+    {
+        // Faces crossing the eye plane are dropped rather than clipped, which only ever loses occlusion.
+        ScreenVertex vertices[4];
+        if (!project(a, vertices[0]) || !project(b, vertices[1]) || !project(c, vertices[2]) || !project(d, vertices[3])) {
+            return;
+        }
+
+        rasterizeTriangle(vertices[0], vertices[1], vertices[2]);
+        rasterizeTriangle(vertices[0], vertices[2], vertices[3]);
+    }
+
+    void OcclusionRasterizer::rasterizeTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c)
+    {
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (std::abs(area) < 1e-6f) {
+            return;
+        }
+
+        int32_t beginX = std::max((int32_t)std::floor(std::min({ a.x, b.x, c.x })), 0);
+        int32_t beginY = std::max((int32_t)std::floor(std::min({ a.y, b.y, c.y })), 0);
+        int32_t endX = std::min((int32_t)std::ceil(std::max({ a.x, b.x, c.x })), (int32_t)width - 1);
+        int32_t endY = std::min((int32_t)std::ceil(std::max({ a.y, b.y, c.y })), (int32_t)height - 1);
+        if (beginX > endX || beginY > endY) {
+            return;
+        }
+
+        stats.triangles++;
+
+        // Edge functions are normalised by the signed area, so they are the barycentric weights of the opposite vertices
+        // and a pixel is covered when all three are non-negative, whatever the winding.
+        float invArea = 1.0f / area;
+        glm::vec3 stepX = glm::vec3(b.y - c.y, c.y - a.y, a.y - b.y) * invArea;
+        glm::vec3 stepY = glm::vec3(c.x - b.x, a.x - c.x, b.x - a.x) * invArea;
+        glm::vec3 origin = glm::vec3(b.x * c.y - c.x * b.y, c.x * a.y - a.x * c.y, a.x * b.y - b.x * a.y) * invArea;
+
+        glm::vec3 invW(a.invW, b.invW, c.invW);
+        float depthStepX = glm::dot(stepX, invW);
+
+        float startX = beginX + 0.5f;
+        for (int32_t y = beginY; y <= endY; y++) {
+            float centerY = y + 0.5f;
+            glm::vec3 rowWeights = origin + stepX * startX + stepY * centerY;
+            float rowDepth = glm::dot(rowWeights, invW);
+            float* row = depth.data() + y * width + beginX;
+            int32_t count = endX - beginX + 1;
+
+            for (int32_t i = 0; i < count; i++) {
+                float offset = (float)i;
+                float w0 = rowWeights.x + stepX.x * offset;
+                float w1 = rowWeights.y + stepX.y * offset;
+                float w2 = rowWeights.z + stepX.z * offset;
+                float pixelDepth = rowDepth + depthStepX * offset;
+
+                bool isCovered = (w0 >= 0.0f) & (w1 >= 0.0f) & (w2 >= 0.0f);
+                row[i] = isCovered && pixelDepth > row[i] ? pixelDepth : row[i];
+            }
+        }
+    }
+}
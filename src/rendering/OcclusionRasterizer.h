@@ -0,0 +1,78 @@
+#pragma once
+
+#include <world/Chunk.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace vmc
+{
+    constexpr uint32_t OccluderCellSize = 4;
+    constexpr uint32_t OccluderCellsPerSide = ChunkWidth / OccluderCellSize;
+
+    const uint32_t DefaultOcclusionBufferWidth = 256;
+    const uint32_t DefaultOcclusionBufferHeight = 128;
+
+    // Heights of the solid slabs standing on the bottom of a chunk, one per square cell of columns. Every block below the height
+    // of a cell is opaque in all of its columns, so the slab can hide whatever lies behind it.
+    struct ChunkOccluder
+    {
+        uint16_t cellHeights[OccluderCellsPerSide * OccluderCellsPerSide] = {};
+    };
+
+    struct OcclusionRasterizerStats
+    {
+        uint32_t occluderBoxes = 0;
+        uint32_t triangles = 0;
+        uint32_t testedBoxes = 0;
+    };
+
+    // Low-resolution CPU depth buffer. Occluder boxes are rasterised into it and bounding boxes are rejected when every texel
+    // under their screen rectangle is closer than their nearest corner. Depth is stored as 1/w, which interpolates linearly in
+    // screen space, with zero meaning nothing was drawn. The inner loops are branch-free over a row so that they vectorise.
+    class OcclusionRasterizer
+    {
+    public:
+        OcclusionRasterizer(uint32_t width = DefaultOcclusionBufferWidth, uint32_t height = DefaultOcclusionBufferHeight);
+
+        void clear(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+        void addOccluder(const glm::vec3& min, const glm::vec3& max);
+
+        void addChunkOccluder(const glm::ivec2& coord, const ChunkOccluder& occluder);
+
+        bool isBoxVisible(const glm::vec3& min, const glm::vec3& max);
+
+        uint32_t getWidth() const;
+
+        uint32_t getHeight() const;
+
+        const OcclusionRasterizerStats& getStats() const;
+
+    private:
+        struct ScreenVertex
+        {
+            float x;
+            float y;
+            float invW;
+        };
+
+        uint32_t width;
+
+        uint32_t height;
+
+        std::vector<float> depth;
+
+        glm::mat4 viewProjection;
+
+        glm::vec3 cameraPosition;
+
+        OcclusionRasterizerStats stats;
+
+        bool project(const glm::vec3& position, ScreenVertex& vertex) const;
+
+        void rasterizeQuad(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d);
+
+        void rasterizeTriangle(const ScreenVertex& a, const ScreenVertex& b, const ScreenVertex& c);
+    };
+}
@@ -0,0 +1,194 @@
+#include "OverlayRenderer.h"
+#include "RenderContext.h"
+#include <common/Utils.h>
+#include <vk/ShaderModule.h>
+#include <cctype>
+#include <cstddef>
+
+namespace vmc
+{
+	const uint32_t OverlayVerticesPerQuad = 6;
+
+	// Rectangles are marked by a negative texture coordinate and drawn without sampling the font.
+	const glm::vec2 OverlaySolidUv(-1.0f, -1.0f);
+
+	OverlayRenderer::OverlayRenderer(const VulkanDevice& device, const RenderPass& renderPass, const DescriptorSetLayout& textureLayout, VkDescriptorSet fontDescriptor, VkPipelineCache pipelineCache, uint32_t scale) :
+		device(device),
+		fontDescriptor(fontDescriptor),
+		scale((float)scale)
+	{
+		auto vertexShaderData = readBinaryFile("data/shaders/overlay.vert.spv");
+		auto fragmentShaderData = readBinaryFile("data/shaders/overlay.frag.spv");
+
+		VulkanShaderModule vertexShader(device, vertexShaderData, VK_SHADER_STAGE_VERTEX_BIT);
+		VulkanShaderModule fragmentShader(device, fragmentShaderData, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+		VkVertexInputBindingDescription vertexBinding{};
+		vertexBinding.binding = 0;
+		vertexBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		vertexBinding.stride = sizeof(OverlayVertex);
+
+		VkVertexInputAttributeDescription positionAttribute{};
+		positionAttribute.binding = 0;
+		positionAttribute.location = 0;
+		positionAttribute.format = VK_FORMAT_R32G32_SFLOAT;
+		positionAttribute.offset = offsetof(OverlayVertex, position);
+
+		VkVertexInputAttributeDescription uvAttribute{};
+		uvAttribute.binding = 0;
+		uvAttribute.location = 1;
+		uvAttribute.format = VK_FORMAT_R32G32_SFLOAT;
+		uvAttribute.offset = offsetof(OverlayVertex, uv);
+
+		VkVertexInputAttributeDescription colorAttribute{};
+		colorAttribute.binding = 0;
+		colorAttribute.location = 2;
+		colorAttribute.format = VK_FORMAT_R8G8B8A8_UNORM;
+		colorAttribute.offset = offsetof(OverlayVertex, color);
+
+		RenderPipelineDescription pipelineDescription;
+		pipelineDescription.renderPass = renderPass.getHandle();
+		pipelineDescription.subpass = 0;
+		pipelineDescription.isAlphaBlendingEnabled = true;
+		pipelineDescription.isDepthTestEnabled = false;
+		pipelineDescription.pipelineCache = pipelineCache;
+		pipelineDescription.shaderModules.push_back(std::move(vertexShader));
+		pipelineDescription.shaderModules.push_back(std::move(fragmentShader));
+		pipelineDescription.vertexBindings.push_back(vertexBinding);
+		pipelineDescription.vertexAttributes = { positionAttribute, uvAttribute, colorAttribute };
+		pipelineDescription.descriptorSetLayouts.push_back(textureLayout.getHandle());
+
+		pipeline = std::make_unique<RenderPipeline>(device, pipelineDescription);
+	}
+
+	OverlayRenderer::~OverlayRenderer()
+	{
+		releaseBuffers();
+	}
+
+	void OverlayRenderer::begin(RenderContext& renderContext)
+	{
+		// Every frame in flight owns a buffer, which is idle again once the frame's fence was waited on in startFrame.
+		if (vertexBuffers.size() != renderContext.getFrameResourceCount()) {
+			releaseBuffers();
+
+			for (uint32_t i = 0; i < renderContext.getFrameResourceCount(); i++) {
+				vertexBuffers.push_back(std::make_unique<VulkanBuffer>(device, MaxOverlayQuads * OverlayVerticesPerQuad * sizeof(OverlayVertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU));
+				mappedVertices.push_back((OverlayVertex*)vertexBuffers.back()->map());
+			}
+		}
+
+		auto frameResourceIndex = renderContext.getFrameResourceIndex();
+		currentBuffer = vertexBuffers[frameResourceIndex].get();
+		vertices = mappedVertices[frameResourceIndex];
+		pixelToClip = glm::vec2(2.0f / renderContext.getWidth(), 2.0f / renderContext.getHeight());
+		quadCount = 0;
+	}
+
+	void OverlayRenderer::addText(float x, float y, const char* text, uint32_t color)
+	{
+		glm::vec2 glyphUvSize(1.0f / OverlayFontColumns, 1.0f / OverlayFontRows);
+
+		float cursorX = x;
+		for (const char* c = text; *c; c++) {
+			if (*c == '\n') {
+				cursorX = x;
+				y += getLineHeight();
+				continue;
+			}
+
+			uint32_t glyph = (uint32_t)std::toupper((unsigned char)*c);
+			if (glyph != ' ' && glyph < OverlayFontColumns * OverlayFontRows) {
+				glm::vec2 uvMin((glyph % OverlayFontColumns) * glyphUvSize.x, (glyph / OverlayFontColumns) * glyphUvSize.y);
+				addQuad(cursorX, y, OverlayGlyphWidth * scale, OverlayGlyphHeight * scale, uvMin, uvMin + glyphUvSize, color);
+			}
+
+			cursorX += (OverlayGlyphWidth + 1) * scale;
+		}
+	}
+
+	void OverlayRenderer::addRectangle(float x, float y, float width, float height, uint32_t color)
+	{
+		addQuad(x, y, width, height, OverlaySolidUv, OverlaySolidUv, color);
+	}
+
+	void OverlayRenderer::record(RenderContext& renderContext, VkCommandBuffer commandBuffer)
+	{
+		if (!currentBuffer || quadCount == 0) {
+			return;
+		}
+
+		currentBuffer->flush(0, quadCount * OverlayVerticesPerQuad * sizeof(OverlayVertex));
+
+		// A pass recorded in secondaries accepts no inline draws. Workers only record while the thread pool runs, so the
+		// first worker's pool is free to use from the main thread here.
+		bool isRecordedInSecondary = renderContext.getSubpassContents() == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+		if (isRecordedInSecondary) {
+			commandBuffer = renderContext.beginSecondaryCommandBuffer(0);
+		}
+
+		auto vertexBuffer = currentBuffer->getHandle();
+		VkDeviceSize offset = 0;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->getHandle());
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->getLayout(), 0, 1, &fontDescriptor, 0, nullptr);
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+		vkCmdDraw(commandBuffer, quadCount * OverlayVerticesPerQuad, 1, 0, 0);
+
+		if (isRecordedInSecondary) {
+			renderContext.endSecondaryCommandBuffer(commandBuffer);
+			secondaryCommandBuffers.assign(1, commandBuffer);
+			renderContext.executeSecondaryCommandBuffers(secondaryCommandBuffers);
+		}
+
+		currentBuffer = nullptr;
+		vertices = nullptr;
+	}
+
+	float OverlayRenderer::getTextWidth(size_t characterCount) const
+	{
+		return characterCount > 0 ? (characterCount * (OverlayGlyphWidth + 1) - 1) * scale : 0.0f;
+	}
+
+	float OverlayRenderer::getLineHeight() const
+	{
+		return (OverlayGlyphHeight + 3) * scale;
+	}
+
+	uint32_t OverlayRenderer::getQuadCount() const
+	{
+		return quadCount;
+	}
+
+	void OverlayRenderer::addQuad(float x, float y, float width, float height, const glm::vec2& uvMin, const glm::vec2& uvMax, uint32_t color)
+	{
+		// Quads past the capacity are dropped, the overlay never grows its buffers while a frame is recorded.
+		if (!vertices || quadCount == MaxOverlayQuads) {
+			return;
+		}
+
+		glm::vec2 clipMin = glm::vec2(x, y) * pixelToClip - 1.0f;
+		glm::vec2 clipMax = glm::vec2(x + width, y + height) * pixelToClip - 1.0f;
+
+		auto quad = vertices + quadCount * OverlayVerticesPerQuad;
+		quad[0] = { clipMin, uvMin, color };
+		quad[1] = { glm::vec2(clipMax.x, clipMin.y), glm::vec2(uvMax.x, uvMin.y), color };
+		quad[2] = { clipMax, uvMax, color };
+		quad[3] = { clipMin, uvMin, color };
+		quad[4] = { clipMax, uvMax, color };
+		quad[5] = { glm::vec2(clipMin.x, clipMax.y), glm::vec2(uvMin.x, uvMax.y), color };
+		quadCount++;
+	}
+
+	void OverlayRenderer::releaseBuffers()
+	{
+		for (auto& buffer : vertexBuffers) {
+			buffer->unmap();
+		}
+
+		vertexBuffers.clear();
+		mappedVertices.clear();
+		currentBuffer = nullptr;
+		vertices = nullptr;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <rendering/RenderPipeline.h>
+#include <rendering/RenderPass.h>
+#include <vk/VulkanBuffer.h>
+#include <vk/DescriptorSetLayout.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include <string>
+
+namespace vmc
+{
+	class RenderContext;
+
+	const uint32_t MaxOverlayQuads = 4096;
+	const uint32_t OverlayGlyphWidth = 5;
+	const uint32_t OverlayGlyphHeight = 7;
+	const uint32_t OverlayFontColumns = 16;
+	const uint32_t OverlayFontRows = 8;
+	const uint32_t DefaultOverlayScale = 2;
+
+	struct OverlayVertex
+	{
+		glm::vec2 position;
+		glm::vec2 uv;
+		uint32_t color;
+	};
+
+	// Colors are packed in the byte order of VK_FORMAT_R8G8B8A8_UNORM.
+	inline uint32_t packOverlayColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255)
+	{
+		return (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | ((uint32_t)a << 24);
+	}
+
+	// Text and filled rectangles in pixel coordinates, batched into one vertex buffer per frame in flight and drawn with a
+	// single draw call on top of the frame. Glyphs come from the bundled 5x7 ASCII font, lower case is drawn as upper case.
+	class OverlayRenderer
+	{
+	public:
+		OverlayRenderer(const VulkanDevice& device, const RenderPass& renderPass, const DescriptorSetLayout& textureLayout, VkDescriptorSet fontDescriptor, VkPipelineCache pipelineCache = VK_NULL_HANDLE, uint32_t scale = DefaultOverlayScale);
+
+		OverlayRenderer(const OverlayRenderer&) = delete;
+
+		OverlayRenderer(OverlayRenderer&& other) = delete;
+
+		~OverlayRenderer();
+
+		OverlayRenderer& operator=(const OverlayRenderer&) = delete;
+
+		OverlayRenderer& operator=(OverlayRenderer&&) = delete;
+
+		// Starts a new batch in the vertex buffer of the current frame, which is only allowed once the frame is started.
+		void begin(RenderContext& renderContext);
+
+		void addText(float x, float y, const char* text, uint32_t color);
+
+		void addRectangle(float x, float y, float width, float height, uint32_t color);
+
+		void record(RenderContext& renderContext, VkCommandBuffer commandBuffer);
+
+		float getTextWidth(size_t characterCount) const;
+
+		float getLineHeight() const;
+
+		uint32_t getQuadCount() const;
+
+	private:
+		const VulkanDevice& device;
+
+		VkDescriptorSet fontDescriptor;
+
+		float scale;
+
+		std::unique_ptr<RenderPipeline> pipeline;
+
+		std::vector<std::unique_ptr<VulkanBuffer>> vertexBuffers;
+
+		std::vector<OverlayVertex*> mappedVertices;
+
+		VulkanBuffer* currentBuffer = nullptr;
+
+		OverlayVertex* vertices = nullptr;
+
+		glm::vec2 pixelToClip{};
+
+		uint32_t quadCount = 0;
+
+		std::vector<VkCommandBuffer> secondaryCommandBuffers;
+
+		void addQuad(float x, float y, float width, float height, const glm::vec2& uvMin, const glm::vec2& uvMax, uint32_t color);
+
+		void releaseBuffers();
+	};
+}
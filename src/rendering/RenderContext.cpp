@@ -1,28 +1,46 @@
 #include "RenderContext.h"
+#include <common/Profiler.h>
 #include <stdexcept>
+#include <cstring>
+#include <algorithm>
 #include <glm/glm.hpp>
 
 namespace vmc
 {
-	RenderContext::RenderContext(VulkanDevice& device, const Window& window, const RenderPass& renderPass, const DescriptorSetLayout& mvpLayout) :
+	RenderContext::RenderContext(VulkanDevice& device, const Window& window, const RenderPass& renderPass, const DescriptorSetLayout& mvpLayout, uint32_t framesInFlight, VkPresentModeKHR presentMode, uint32_t workerCount) :
 		renderPass(renderPass),
-		device(device)
+		device(device),
+		workerCount(workerCount)
 	{
-		swapchain = std::make_unique<VulkanSwapchain>(device, device.getSurfaceFormat(), window.getSurface(), window.getWidth(), window.getHeight());
-		initCommandPool();
-		initSwapchainResources();
-		initFrameResources(mvpLayout);
+		swapchain = std::make_unique<VulkanSwapchain>(device, device.getSurfaceFormat(), window.getSurface(), window.getWidth(), window.getHeight(), presentMode);
+		initResources(mvpLayout, framesInFlight);
+	}
+
+	RenderContext::RenderContext(VulkanDevice& device, uint32_t width, uint32_t height, const RenderPass& renderPass, const DescriptorSetLayout& mvpLayout, uint32_t framesInFlight, uint32_t workerCount) :
+		renderPass(renderPass),
+		device(device),
+		workerCount(workerCount)
+	{
+		// Without a swapchain every frame in flight renders into its own color image, which is never presented.
+		offscreenExtent = { width, height };
+		initResources(mvpLayout, framesInFlight);
 	}
 
 	RenderContext::~RenderContext()
 	{
-		for (const auto& frameResource : frameResources) {
+		for (auto& frameResource : frameResources) {
+			releaseRetiredResources(frameResource);
+
+			for (auto& pool : frameResource.secondaryCommandPools) {
+				vkDestroyCommandPool(device.getHandle(), pool.handle, nullptr);
+			}
+
 			vkDestroySemaphore(device.getHandle(), frameResource.imageAvailableSemaphore, nullptr);
 			vkDestroySemaphore(device.getHandle(), frameResource.renderingFinishedSemaphore, nullptr);
 			vkDestroyFence(device.getHandle(), frameResource.fence, nullptr);
 		}
 
-		destroySwapchainResources();
+		destroyRenderTargets();
 
 		if (commandPool != VK_NULL_HANDLE) {
 			vkDestroyCommandPool(device.getHandle(), commandPool, nullptr);
@@ -31,7 +49,7 @@ namespace vmc
 		swapchain.reset();
 	}
 
-	VkCommandBuffer RenderContext::startFrame(VkClearColorValue clearColor)
+	VkCommandBuffer RenderContext::startFrame(VkClearColorValue clearColor, RenderPassMode renderPassMode, VkSubpassContents subpassContents)
 	{
 		if (isFrameStarted) {
 			throw std::runtime_error("Cannot start a new frame before the previous is ended.");
@@ -40,20 +58,63 @@ namespace vmc
 		auto& resource = frameResources[frameResourceIndex];
 		auto commandBuffer = commandBuffers[frameResourceIndex];
 
-		vkWaitForFences(device.getHandle(), 1, &resource.fence, VK_TRUE, UINT64_MAX);
-		vkResetFences(device.getHandle(), 1, &resource.fence);
+		{
+			VMC_PROFILE_ZONE("wait for frame");
+			vkWaitForFences(device.getHandle(), 1, &resource.fence, VK_TRUE, UINT64_MAX);
+		}
+		gpuProfiler->beginSlot(frameResourceIndex);
+		releaseRetiredResources(resource);
+		resetSecondaryCommandPools(resource);
+		lastStartedFrameResourceIndex = frameResourceIndex;
 
 		vkResetCommandBuffer(commandBuffer, 0);
 
-		auto result = vkAcquireNextImageKHR(device.getHandle(), swapchain->getHandle(), UINT64_MAX, resource.imageAvailableSemaphore, VK_NULL_HANDLE, &currentImageIndex);
-		if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR) {
-			handleSurfaceChanges();
-			vkAcquireNextImageKHR(device.getHandle(), swapchain->getHandle(), UINT64_MAX, resource.imageAvailableSemaphore, VK_NULL_HANDLE, &currentImageIndex);
+		// A suboptimal image is still acquired and signals the semaphore, so it is rendered and the swapchain is only
+		// recreated after presenting it.
+		if (swapchain) {
+			VMC_PROFILE_ZONE("acquire image");
+			auto result = vkAcquireNextImageKHR(device.getHandle(), swapchain->getHandle(), UINT64_MAX, resource.imageAvailableSemaphore, VK_NULL_HANDLE, &currentImageIndex);
+			if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+				handleSurfaceChanges(true);
+				result = vkAcquireNextImageKHR(device.getHandle(), swapchain->getHandle(), UINT64_MAX, resource.imageAvailableSemaphore, VK_NULL_HANDLE, &currentImageIndex);
+			}
+
+			// A minimised window keeps its out-of-date swapchain, so its frames are skipped until it has an extent again.
+			if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+				return VK_NULL_HANDLE;
+			}
+
+			if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+				throw std::runtime_error("Cannot acquire swapchain image.");
+			}
+		}
+		else {
+			currentImageIndex = frameResourceIndex;
+		}
+
+		// With fewer frames in flight than swapchain images, the acquired image can still be used by another frame's
+		// submission, whose fence is the one recorded for the image. The frame's own fence is only reset at submission,
+		// so this wait cannot block on a fence that will never be signalled.
+		auto& imageFence = imageFences[currentImageIndex];
+		if (imageFence != VK_NULL_HANDLE && imageFence != resource.fence) {
+			VMC_PROFILE_ZONE("wait for image");
+			vkWaitForFences(device.getHandle(), 1, &imageFence, VK_TRUE, UINT64_MAX);
 		}
+		imageFence = resource.fence;
 
-		beginRecordingCommandBuffer(commandBuffer, framebuffers[currentImageIndex], clearColor);
+		currentClearColor = clearColor;
+		currentRenderPassMode = renderPassMode;
+		currentRenderPassStage = RenderPassStage::Complete;
+		currentSubpassContents = subpassContents;
+		beginRecordingCommandBuffer(commandBuffer);
 		isFrameStarted = true;
-		resource.mvpUniform->reset();
+
+		// A split frame leaves room for compute work before the first pass, which the caller begins explicitly.
+		if (renderPassMode == RenderPassMode::Single) {
+			beginRenderPass(renderPass, RenderPassStage::Complete);
+		}
+
+		resource.uniformAllocator->reset();
 		return commandBuffer;
 	}
 
@@ -65,77 +126,410 @@ namespace vmc
 
 		auto& resource = frameResources[frameResourceIndex];
 		auto commandBuffer = commandBuffers[frameResourceIndex];
-		resource.mvpUniform->flush();
+		resource.uniformAllocator->flush();
+
+		// Split frames always finish in the resume pass, which transitions the color attachment for presentation.
+		if (currentRenderPassMode == RenderPassMode::Split && currentRenderPassStage != RenderPassStage::Resume) {
+			if (!isRenderPassActive) {
+				beginRenderPass();
+			}
+			suspendRenderPass();
+			resumeRenderPass();
+		}
 
 		endRecordingCommandBuffer(commandBuffer);
 
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		if (swapchain) {
+			waitSemaphores.push_back(resource.imageAvailableSemaphore);
+			waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+
 		VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &resource.imageAvailableSemaphore;
-		submitInfo.pWaitDstStageMask = waitStages;
-		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.waitSemaphoreCount = waitSemaphores.size();
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+		submitInfo.signalSemaphoreCount = swapchain ? 1 : 0;
 		submitInfo.pSignalSemaphores = &resource.renderingFinishedSemaphore;
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer;
 
-		if (vkQueueSubmit(device.getGraphicsQueue(), 1, &submitInfo, resource.fence) != VK_SUCCESS) {
+		VMC_PROFILE_ZONE("submit frame");
+		vkResetFences(device.getHandle(), 1, &resource.fence);
+		auto submitResult = vkQueueSubmit(device.getGraphicsQueue(), 1, &submitInfo, resource.fence);
+		lastSubmitTime = std::chrono::steady_clock::now();
+		waitSemaphores.clear();
+		waitStages.clear();
+
+		if (submitResult != VK_SUCCESS) {
 			throw std::runtime_error("Cannot submit command buffer.");
 		}
 
-		auto swapchainHandle = swapchain->getHandle();
-		VkPresentInfoKHR presentInfo{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
-		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = &resource.renderingFinishedSemaphore;
-		presentInfo.swapchainCount = 1;
-		presentInfo.pSwapchains = &swapchainHandle;
-		presentInfo.pImageIndices = &currentImageIndex;
-
-		auto result = vkQueuePresentKHR(device.getPresentQueue(), &presentInfo);
-		if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR) {
-			handleSurfaceChanges();
-		}
-		else if (result != VK_SUCCESS) {
-			throw std::runtime_error("Cannot present to swapchain.");
+		if (swapchain) {
+			VMC_PROFILE_ZONE("present");
+			auto swapchainHandle = swapchain->getHandle();
+			VkPresentInfoKHR presentInfo{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
+			presentInfo.waitSemaphoreCount = 1;
+			presentInfo.pWaitSemaphores = &resource.renderingFinishedSemaphore;
+			presentInfo.swapchainCount = 1;
+			presentInfo.pSwapchains = &swapchainHandle;
+			presentInfo.pImageIndices = &currentImageIndex;
+
+			auto result = vkQueuePresentKHR(device.getPresentQueue(), &presentInfo);
+			if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR) {
+				handleSurfaceChanges(result == VK_ERROR_OUT_OF_DATE_KHR);
+			}
+			else if (result != VK_SUCCESS) {
+				throw std::runtime_error("Cannot present to swapchain.");
+			}
 		}
 
 		frameResourceIndex = (frameResourceIndex + 1) % (uint32_t)frameResources.size();
 		isFrameStarted = false;
 	}
 
+	void RenderContext::beginRenderPass()
+	{
+		if (!isFrameStarted || currentRenderPassMode != RenderPassMode::Split || isRenderPassActive || currentRenderPassStage == RenderPassStage::Begin) {
+			throw std::runtime_error("Cannot begin the render pass of this frame.");
+		}
+
+		beginRenderPass(*splitBeginPass, RenderPassStage::Begin);
+	}
+
+	void RenderContext::suspendRenderPass()
+	{
+		if (!isRenderPassActive || currentRenderPassStage != RenderPassStage::Begin) {
+			throw std::runtime_error("Cannot suspend the render pass of this frame.");
+		}
+
+		vkCmdEndRenderPass(commandBuffers[frameResourceIndex]);
+		gpuProfiler->endScope(commandBuffers[frameResourceIndex], renderPassGpuScope);
+		isRenderPassActive = false;
+	}
+
+	void RenderContext::resumeRenderPass()
+	{
+		if (isRenderPassActive || currentRenderPassStage != RenderPassStage::Begin) {
+			throw std::runtime_error("Cannot resume the render pass of this frame.");
+		}
+
+		beginRenderPass(*splitResumePass, RenderPassStage::Resume);
+	}
+
+	VkCommandBuffer RenderContext::beginSecondaryCommandBuffer(uint32_t workerIndex)
+	{
+		if (!isRenderPassActive || currentSubpassContents != VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS || workerIndex >= workerCount) {
+			throw std::runtime_error("Cannot begin a secondary command buffer outside a secondary render pass.");
+		}
+
+		// Every worker owns its pool, so workers can record concurrently without any locking.
+		auto& pool = frameResources[frameResourceIndex].secondaryCommandPools[workerIndex];
+		if (pool.usedCount == pool.commandBuffers.size()) {
+			VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+			allocateInfo.commandPool = pool.handle;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocateInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot allocate secondary command buffer.");
+			}
+			pool.commandBuffers.push_back(commandBuffer);
+		}
+
+		auto commandBuffer = pool.commandBuffers[pool.usedCount++];
+		beginSecondaryCommandBuffer(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, getCurrentFramebuffer());
+		return commandBuffer;
+	}
+
+	void RenderContext::beginReusableCommandBuffer(VkCommandBuffer commandBuffer)
+	{
+		if (!isRenderPassActive || currentSubpassContents != VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+			throw std::runtime_error("Cannot begin a secondary command buffer outside a secondary render pass.");
+		}
+
+		// The framebuffer is left out, so the recording stays valid for every swapchain image.
+		beginSecondaryCommandBuffer(commandBuffer, 0, VK_NULL_HANDLE);
+	}
+
+	void RenderContext::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+	{
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot end secondary command buffer.");
+		}
+	}
+
+	void RenderContext::executeSecondaryCommandBuffers(const std::vector<VkCommandBuffer>& secondaryCommandBuffers)
+	{
+		if (!isRenderPassActive || currentSubpassContents != VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+			throw std::runtime_error("Cannot execute secondary command buffers outside a secondary render pass.");
+		}
+
+		if (!secondaryCommandBuffers.empty()) {
+			vkCmdExecuteCommands(commandBuffers[frameResourceIndex], (uint32_t)secondaryCommandBuffers.size(), secondaryCommandBuffers.data());
+		}
+	}
+
+	uint32_t RenderContext::getWorkerCount() const
+	{
+		return workerCount;
+	}
+
+	std::chrono::steady_clock::time_point RenderContext::getLastSubmitTime() const
+	{
+		return lastSubmitTime;
+	}
+
 	uint32_t RenderContext::getWidth() const
 	{
-		return swapchain->getExtent().width;
+		return getExtent().width;
 	}
 
 	uint32_t RenderContext::getHeight() const
 	{
-		return swapchain->getExtent().height;
+		return getExtent().height;
 	}
 
-	DynamicUniform& RenderContext::getMVPUniform()
+	bool RenderContext::isOffscreen() const
 	{
-		return *frameResources[frameResourceIndex].mvpUniform;
+		return !swapchain;
+	}
+
+	std::vector<uint8_t> RenderContext::readLastFrame()
+	{
+		if (swapchain || isFrameStarted) {
+			throw std::runtime_error("Cannot read back a frame that is not rendered offscreen.");
+		}
+
+		auto extent = getExtent();
+		VkDeviceSize size = (VkDeviceSize)extent.width * extent.height * 4;
+		VulkanBuffer readbackBuffer(device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+
+		// Reading a frame back is rare, so it simply waits for the device and copies with a one-off command buffer.
+		device.waitIdle();
+
+		VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		allocateInfo.commandPool = commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot allocate command buffers.");
+		}
+
+		beginRecordingCommandBuffer(commandBuffer);
+
+		VkBufferImageCopy region{};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { extent.width, extent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, colorImages[lastStartedFrameResourceIndex].getHandle(), OffscreenColorLayout, readbackBuffer.getHandle(), 1, &region);
+
+		VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		vkEndCommandBuffer(commandBuffer);
+
+		VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+
+		auto submitResult = vkQueueSubmit(device.getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+		if (submitResult == VK_SUCCESS) {
+			vkQueueWaitIdle(device.getGraphicsQueue());
+		}
+		vkFreeCommandBuffers(device.getHandle(), commandPool, 1, &commandBuffer);
+
+		if (submitResult != VK_SUCCESS) {
+			throw std::runtime_error("Cannot submit command buffer.");
+		}
+
+		// Pixels are returned as RGBA, whatever the order of the color format.
+		std::vector<uint8_t> pixels(size);
+		readbackBuffer.invalidate(0, size);
+		memcpy(pixels.data(), readbackBuffer.map(), size);
+		readbackBuffer.unmap();
+
+		if (device.getSurfaceFormat().format == VK_FORMAT_B8G8R8A8_UNORM) {
+			for (size_t i = 0; i < pixels.size(); i += 4) {
+				std::swap(pixels[i], pixels[i + 2]);
+			}
+		}
+
+		return pixels;
+	}
+
+	UniformAllocator& RenderContext::getUniformAllocator()
+	{
+		return *frameResources[frameResourceIndex].uniformAllocator;
+	}
+
+	GpuProfiler& RenderContext::getGpuProfiler()
+	{
+		return *gpuProfiler;
+	}
+
+	VkSubpassContents RenderContext::getSubpassContents() const
+	{
+		return currentSubpassContents;
+	}
+
+	const VulkanImageView& RenderContext::getDepthImageView() const
+	{
+		return depthImageViews[frameResourceIndex];
+	}
+
+	uint32_t RenderContext::getFrameResourceIndex() const
+	{
+		return frameResourceIndex;
+	}
+
+	uint32_t RenderContext::getFrameResourceCount() const
+	{
+		return (uint32_t)frameResources.size();
+	}
+
+	void RenderContext::addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage)
+	{
+		waitSemaphores.push_back(semaphore);
+		waitStages.push_back(waitStage);
+	}
+
+	void RenderContext::retire(VulkanBuffer&& buffer)
+	{
+		getRetirementFrameResources().retiredBuffers.push_back(std::move(buffer));
+	}
+
+	void RenderContext::retire(VulkanImage&& image)
+	{
+		getRetirementFrameResources().retiredImages.push_back(std::move(image));
+	}
+
+	void RenderContext::retire(VulkanImageView&& imageView)
+	{
+		getRetirementFrameResources().retiredImageViews.push_back(std::move(imageView));
+	}
+
+	void RenderContext::retire(Mesh&& mesh)
+	{
+		getRetirementFrameResources().retiredMeshes.push_back(std::move(mesh));
+	}
+
+	void RenderContext::retire(DescriptorPool& pool, VkDescriptorSet descriptorSet)
+	{
+		getRetirementFrameResources().retiredDescriptorSets.emplace_back(&pool, descriptorSet);
+	}
+
+	void RenderContext::retire(std::unique_ptr<DescriptorPool>&& pool)
+	{
+		getRetirementFrameResources().retiredDescriptorPools.push_back(std::move(pool));
+	}
+
+	void RenderContext::releaseRetiredResources(FrameResources& resource)
+	{
+		for (auto& entry : resource.retiredDescriptorSets) {
+			entry.first->free(entry.second);
+		}
+
+		for (auto framebuffer : resource.retiredFramebuffers) {
+			vkDestroyFramebuffer(device.getHandle(), framebuffer, nullptr);
+		}
+
+		// Views of swapchain images have to go before their swapchain.
+		resource.retiredDescriptorSets.clear();
+		resource.retiredDescriptorPools.clear();
+		resource.retiredMeshes.clear();
+		resource.retiredFramebuffers.clear();
+		resource.retiredImageViews.clear();
+		resource.retiredImages.clear();
+		resource.retiredBuffers.clear();
+		resource.retiredSwapchains.clear();
+	}
+
+	void RenderContext::resetSecondaryCommandPools(FrameResources& resource)
+	{
+		for (auto& pool : resource.secondaryCommandPools) {
+			if (pool.usedCount > 0) {
+				vkResetCommandPool(device.getHandle(), pool.handle, 0);
+				pool.usedCount = 0;
+			}
+		}
+	}
+
+	FrameResources& RenderContext::getRetirementFrameResources()
+	{
+		// Resources retired now may still be referenced by the most recently started frame, so they are released after its fence.
+		return frameResources[lastStartedFrameResourceIndex];
+	}
+
+	void RenderContext::initResources(const DescriptorSetLayout& mvpLayout, uint32_t framesInFlight)
+	{
+		auto colorFinalLayout = swapchain ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : OffscreenColorLayout;
+		splitBeginPass = std::make_unique<RenderPass>(device, device.getSurfaceFormat().format, RenderPassStage::Begin);
+		splitResumePass = std::make_unique<RenderPass>(device, device.getSurfaceFormat().format, RenderPassStage::Resume, colorFinalLayout);
+		initCommandPool();
+		initFrameResources(mvpLayout, framesInFlight);
+		initCommandBuffers();
+
+		// Every frame in flight owns a query pool, which is read back once the frame's fence is waited on again.
+		gpuProfiler = std::make_unique<GpuProfiler>(device, framesInFlight);
+		initRenderTargets();
 	}
 
 	void RenderContext::initImages()
 	{
-		auto swapchainImages = swapchain->getImages();
+		if (swapchain) {
+			auto swapchainImages = swapchain->getImages();
+
+			for (uint32_t i = 0; i < swapchainImages.size(); i++) {
+				colorImageViews.emplace_back(device, swapchainImages[i], device.getSurfaceFormat().format, VK_IMAGE_ASPECT_COLOR_BIT);
+			}
+		}
+		else {
+			for (uint32_t i = 0; i < frameResources.size(); i++) {
+				VkImageUsageFlags colorUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				colorImages.emplace_back(device, getWidth(), getHeight(), device.getSurfaceFormat().format, VK_SAMPLE_COUNT_1_BIT, colorUsage, VMA_MEMORY_USAGE_GPU_ONLY);
+				colorImageViews.emplace_back(device, colorImages.back(), VK_IMAGE_ASPECT_COLOR_BIT);
+			}
+		}
 
-		for (uint32_t i = 0; i < swapchainImages.size(); i++) {
-			swapchainImageViews.emplace_back(device, swapchainImages[i], device.getSurfaceFormat().format, VK_IMAGE_ASPECT_COLOR_BIT);
+		// Framebuffers may be smaller than their attachments, so depth images are only replaced when the surface outgrows them.
+		if (!depthImages.empty() && getWidth() <= depthImages[0].getWidth() && getHeight() <= depthImages[0].getHeight()) {
+			return;
+		}
 
-			depthImages.emplace_back(device, getWidth(), getHeight(), device.getDepthFormat(), VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+		auto& retirement = getRetirementFrameResources();
+		for (auto& imageView : depthImageViews) {
+			retirement.retiredImageViews.push_back(std::move(imageView));
+		}
+		for (auto& image : depthImages) {
+			retirement.retiredImages.push_back(std::move(image));
+		}
+		depthImageViews.clear();
+		depthImages.clear();
+
+		// Depth is only used while a frame is recorded and executed, so one image per frame in flight is enough.
+		for (uint32_t i = 0; i < frameResources.size(); i++) {
+			VkImageUsageFlags depthUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			if (device.isDepthSamplingSupported()) {
+				depthUsage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+			}
+
+			depthImages.emplace_back(device, getWidth(), getHeight(), device.getDepthFormat(), VK_SAMPLE_COUNT_1_BIT, depthUsage, VMA_MEMORY_USAGE_GPU_ONLY);
 			depthImageViews.emplace_back(device, depthImages.back(), VK_IMAGE_ASPECT_DEPTH_BIT);
 		}
 	}
 
 	void RenderContext::initFramebuffers()
 	{
-		auto extent = swapchain->getExtent();
-		framebuffers.resize(swapchainImageViews.size(), VK_NULL_HANDLE);
+		// Every pairing of a color image with the depth image of a frame in flight gets its own framebuffer.
+		auto extent = getExtent();
+		uint32_t frameCount = (uint32_t)frameResources.size();
+		framebuffers.resize(colorImageViews.size() * frameCount, VK_NULL_HANDLE);
 		for (uint32_t i = 0; i < framebuffers.size(); i++) {
-			std::vector<VkImageView> attachments = { swapchainImageViews[i].getHandle(), depthImageViews[i].getHandle() };
+			std::vector<VkImageView> attachments = { colorImageViews[i / frameCount].getHandle(), depthImageViews[i % frameCount].getHandle() };
 
 			VkFramebufferCreateInfo createInfo{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
 			createInfo.attachmentCount = attachments.size();
@@ -164,7 +558,7 @@ namespace vmc
 
 	void RenderContext::initCommandBuffers()
 	{
-		commandBuffers.resize(framebuffers.size());
+		commandBuffers.resize(frameResources.size());
 
 		VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
 		allocateInfo.commandPool = commandPool;
@@ -176,10 +570,9 @@ namespace vmc
 		}
 	}
 
-	void RenderContext::initFrameResources(const DescriptorSetLayout& mvpLayout)
+	void RenderContext::initFrameResources(const DescriptorSetLayout& mvpLayout, uint32_t framesInFlight)
 	{
-		frameResources.resize(framebuffers.size());
-		descriptorPool = std::make_unique<DescriptorPool>(device, 0, framebuffers.size(), 0, framebuffers.size());
+		frameResources.resize(framesInFlight);
 
 		VkSemaphoreCreateInfo semaphoreCreateInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
 		VkFenceCreateInfo fenceCreateInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
@@ -195,11 +588,23 @@ namespace vmc
 				throw std::runtime_error("Cannot create fence.");
 			}
 
-			frameResources[i].mvpUniform = std::make_unique<DynamicUniform>(device, *descriptorPool, mvpLayout.getHandle(), sizeof(glm::mat4), 1024);
+			frameResources[i].uniformAllocator = std::make_unique<UniformAllocator>(device, mvpLayout.getHandle());
+
+			// Secondary buffers are reset all at once through their pool, after the fence of their frame.
+			VkCommandPoolCreateInfo poolCreateInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+			poolCreateInfo.queueFamilyIndex = device.getGraphicsQueueFamilyIndex();
+			poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+			frameResources[i].secondaryCommandPools.resize(workerCount);
+			for (auto& pool : frameResources[i].secondaryCommandPools) {
+				if (vkCreateCommandPool(device.getHandle(), &poolCreateInfo, nullptr, &pool.handle) != VK_SUCCESS) {
+					throw std::runtime_error("Cannot create command pool.");
+				}
+			}
 		}
 	}
 
-	void RenderContext::handleSurfaceChanges()
+	void RenderContext::handleSurfaceChanges(bool isOutOfDate)
 	{
 		VkSurfaceCapabilitiesKHR properties;
 		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.getPhysicalDevice(), swapchain->getSurface(), &properties);
@@ -207,57 +612,97 @@ namespace vmc
 		auto extent = swapchain->getExtent();
 		auto newExtent = properties.currentExtent;
 
-		if (newExtent.width != extent.width || newExtent.height != extent.height) {
-			device.waitIdle();
-			destroySwapchainResources();
-			swapchain = std::make_unique<VulkanSwapchain>(*swapchain, newExtent.width, newExtent.height);
-			initSwapchainResources();
+		// A minimised window has no extent to create a swapchain with, so the old one is kept until it is restored.
+		if (newExtent.width == 0 || newExtent.height == 0) {
+			return;
 		}
+
+		if (!isOutOfDate && newExtent.width == extent.width && newExtent.height == extent.height) {
+			return;
+		}
+
+		// Frames still in flight keep using the old swapchain and its framebuffers, so instead of idling the device they are
+		// retired with the current frame, whose fence is signalled after every earlier submission.
+		auto& retirement = getRetirementFrameResources();
+		for (auto framebuffer : framebuffers) {
+			retirement.retiredFramebuffers.push_back(framebuffer);
+		}
+		for (auto& imageView : colorImageViews) {
+			retirement.retiredImageViews.push_back(std::move(imageView));
+		}
+		framebuffers.clear();
+		colorImageViews.clear();
+
+		auto newSwapchain = std::make_unique<VulkanSwapchain>(*swapchain, newExtent.width, newExtent.height);
+		retirement.retiredSwapchains.push_back(std::move(swapchain));
+		swapchain = std::move(newSwapchain);
+
+		initRenderTargets();
 	}
 
-	void RenderContext::destroySwapchainResources()
+	void RenderContext::destroyRenderTargets()
 	{
 		for (auto framebuffer : framebuffers) {
 			vkDestroyFramebuffer(device.getHandle(), framebuffer, nullptr);
 		}
-
-		vkFreeCommandBuffers(device.getHandle(), commandPool, commandBuffers.size(), commandBuffers.data());
-		commandBuffers.clear();
+		framebuffers.clear();
+		imageFences.clear();
 
         depthImageViews.clear();
         depthImages.clear();
 
-        swapchainImageViews.clear();
+        colorImageViews.clear();
+        colorImages.clear();
 	}
 
-	void RenderContext::initSwapchainResources()
+	void RenderContext::initRenderTargets()
 	{
 		initImages();
 		initFramebuffers();
-		initCommandBuffers();
+		imageFences.assign(colorImageViews.size(), VK_NULL_HANDLE);
 	}
 
-	void RenderContext::beginRecordingCommandBuffer(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkClearColorValue clearColor)
+	void RenderContext::beginRecordingCommandBuffer(VkCommandBuffer commandBuffer)
 	{
 		VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
 		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	}
+
+	void RenderContext::beginRenderPass(const RenderPass& pass, RenderPassStage stage)
+	{
+		auto commandBuffer = commandBuffers[frameResourceIndex];
 
 		std::vector< VkClearValue> clearValues(2);
-		clearValues[0].color = clearColor;
+		clearValues[0].color = currentClearColor;
 		clearValues[1].depthStencil = { 1.0f, 0 };
 
 		VkRenderPassBeginInfo renderPassInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-		renderPassInfo.renderPass = renderPass.getHandle();
-		renderPassInfo.framebuffer = framebuffer;
+		renderPassInfo.renderPass = pass.getHandle();
+		renderPassInfo.framebuffer = getCurrentFramebuffer();
 		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = swapchain->getExtent();
+		renderPassInfo.renderArea.extent = getExtent();
 		renderPassInfo.clearValueCount = clearValues.size();
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// Timestamps cannot be written into a pass recorded in secondaries, so the pass is timed from outside.
+		auto scopeName = stage == RenderPassStage::Resume ? "resumed render pass" : "render pass";
+		renderPassGpuScope = gpuProfiler->beginScope(commandBuffer, scopeName, device.getGraphicsQueueFamilyIndex());
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, currentSubpassContents);
 
-		auto extent = swapchain->getExtent();
+		// A pass recorded in secondary command buffers accepts no other commands, the secondaries set their own state.
+		if (currentSubpassContents == VK_SUBPASS_CONTENTS_INLINE) {
+			setViewportAndScissor(commandBuffer);
+		}
+
+		currentRenderPass = &pass;
+		currentRenderPassStage = stage;
+		isRenderPassActive = true;
+	}
+
+	void RenderContext::setViewportAndScissor(VkCommandBuffer commandBuffer)
+	{
+		auto extent = getExtent();
 
 		VkViewport viewport;
 		viewport.x = 0.0f;
@@ -275,9 +720,40 @@ namespace vmc
 		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 	}
 
+	VkFramebuffer RenderContext::getCurrentFramebuffer() const
+	{
+		return framebuffers[currentImageIndex * frameResources.size() + frameResourceIndex];
+	}
+
+	VkExtent2D RenderContext::getExtent() const
+	{
+		return swapchain ? swapchain->getExtent() : offscreenExtent;
+	}
+
+	void RenderContext::beginSecondaryCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags usage, VkFramebuffer framebuffer)
+	{
+		VkCommandBufferInheritanceInfo inheritanceInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+		inheritanceInfo.renderPass = currentRenderPass->getHandle();
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = usage | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot begin secondary command buffer.");
+		}
+
+		// Dynamic state is not inherited from the primary command buffer.
+		setViewportAndScissor(commandBuffer);
+	}
+
 	void RenderContext::endRecordingCommandBuffer(VkCommandBuffer commandBuffer)
 	{
 		vkCmdEndRenderPass(commandBuffer);
+		gpuProfiler->endScope(commandBuffer, renderPassGpuScope);
+		isRenderPassActive = false;
 		vkEndCommandBuffer(commandBuffer);
 	}
 }
\ No newline at end of file
@@ -5,24 +5,53 @@
 #include "RenderPass.h"
 #include <core/Window.h>
 #include <vk/DescriptorSetLayout.h>
-#include <vk/DynamicUniform.h>
+#include <vk/UniformAllocator.h>
 #include <vk/VulkanImage.h>
+#include <vk/GpuProfiler.h>
+#include <rendering/Mesh.h>
 #include <memory>
+#include <chrono>
 
 namespace vmc
 {
+	const VkImageLayout OffscreenColorLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+	struct SecondaryCommandPool
+	{
+		VkCommandPool handle = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> commandBuffers;
+		uint32_t usedCount = 0;
+	};
+
 	struct FrameResources
 	{
 		VkSemaphore renderingFinishedSemaphore;
 		VkSemaphore imageAvailableSemaphore;
 		VkFence fence;
-		std::unique_ptr<DynamicUniform> mvpUniform;
+		std::unique_ptr<UniformAllocator> uniformAllocator;
+		std::vector<SecondaryCommandPool> secondaryCommandPools;
+		std::vector<VulkanBuffer> retiredBuffers;
+		std::vector<VulkanImage> retiredImages;
+		std::vector<VulkanImageView> retiredImageViews;
+		std::vector<VkFramebuffer> retiredFramebuffers;
+		std::vector<std::unique_ptr<VulkanSwapchain>> retiredSwapchains;
+		std::vector<Mesh> retiredMeshes;
+		std::vector<std::pair<DescriptorPool*, VkDescriptorSet>> retiredDescriptorSets;
+		std::vector<std::unique_ptr<DescriptorPool>> retiredDescriptorPools;
+	};
+
+	enum class RenderPassMode
+	{
+		Single,
+		Split
 	};
 
 	class RenderContext
 	{
 	public:
-		RenderContext(VulkanDevice& device, const Window& window, const RenderPass& renderPass, const DescriptorSetLayout& mvpLayout);
+		RenderContext(VulkanDevice& device, const Window& window, const RenderPass& renderPass, const DescriptorSetLayout& mvpLayout, uint32_t framesInFlight, VkPresentModeKHR presentMode, uint32_t workerCount = 1);
+
+		RenderContext(VulkanDevice& device, uint32_t width, uint32_t height, const RenderPass& renderPass, const DescriptorSetLayout& mvpLayout, uint32_t framesInFlight, uint32_t workerCount = 1);
 
 		RenderContext(const RenderContext&) = delete;
 
@@ -34,7 +63,26 @@ namespace vmc
 
 		RenderContext& operator=(RenderContext&&) = delete;
 
-		VkCommandBuffer startFrame(VkClearColorValue clearColor);
+		// Returns VK_NULL_HANDLE when the swapchain has no image to render to, the frame is then skipped and not ended.
+		VkCommandBuffer startFrame(VkClearColorValue clearColor, RenderPassMode renderPassMode = RenderPassMode::Single, VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE);
+
+		VkCommandBuffer beginSecondaryCommandBuffer(uint32_t workerIndex);
+
+		void beginReusableCommandBuffer(VkCommandBuffer commandBuffer);
+
+		void endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+
+		void executeSecondaryCommandBuffers(const std::vector<VkCommandBuffer>& secondaryCommandBuffers);
+
+		uint32_t getWorkerCount() const;
+
+		std::chrono::steady_clock::time_point getLastSubmitTime() const;
+
+		void beginRenderPass();
+
+		void suspendRenderPass();
+
+		void resumeRenderPass();
 
 		void endFrame();
 
@@ -42,16 +90,46 @@ namespace vmc
 
 		uint32_t getHeight() const;
 
-		DynamicUniform& getMVPUniform();
+		bool isOffscreen() const;
+
+		std::vector<uint8_t> readLastFrame();
+
+		UniformAllocator& getUniformAllocator();
+
+		GpuProfiler& getGpuProfiler();
+
+		VkSubpassContents getSubpassContents() const;
+
+		const VulkanImageView& getDepthImageView() const;
+
+		uint32_t getFrameResourceIndex() const;
+
+		uint32_t getFrameResourceCount() const;
+
+		void addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags waitStage);
+
+		void retire(VulkanBuffer&& buffer);
+
+		void retire(VulkanImage&& image);
+
+		void retire(VulkanImageView&& imageView);
+
+		void retire(Mesh&& mesh);
+
+		void retire(DescriptorPool& pool, VkDescriptorSet descriptorSet);
+
+		void retire(std::unique_ptr<DescriptorPool>&& pool);
 
 	private:
 		VulkanDevice& device;
 
 		std::unique_ptr<VulkanSwapchain> swapchain;
 
-		std::unique_ptr<DescriptorPool> descriptorPool;
+		VkExtent2D offscreenExtent{};
+
+		std::vector<VulkanImage> colorImages;
 
-		std::vector<VulkanImageView> swapchainImageViews;
+		std::vector<VulkanImageView> colorImageViews;
 
 		std::vector<VulkanImage> depthImages;
 
@@ -59,8 +137,14 @@ namespace vmc
 
 		std::vector<VkFramebuffer> framebuffers;
 
+		std::vector<VkFence> imageFences;
+
 		const RenderPass& renderPass;
 
+		std::unique_ptr<RenderPass> splitBeginPass;
+
+		std::unique_ptr<RenderPass> splitResumePass;
+
 		VkCommandPool commandPool = VK_NULL_HANDLE;
 
 		std::vector<VkCommandBuffer> commandBuffers;
@@ -69,6 +153,22 @@ namespace vmc
 
 		uint32_t frameResourceIndex = 0;
 
+		uint32_t lastStartedFrameResourceIndex = 0;
+
+		std::vector<VkSemaphore> waitSemaphores;
+
+		std::vector<VkPipelineStageFlags> waitStages;
+
+		uint32_t workerCount;
+
+		std::chrono::steady_clock::time_point lastSubmitTime;
+
+		std::unique_ptr<GpuProfiler> gpuProfiler;
+
+		uint32_t renderPassGpuScope = InvalidGpuScope;
+
+		void initResources(const DescriptorSetLayout& mvpLayout, uint32_t framesInFlight);
+
 		void initImages();
 
 		void initFramebuffers();
@@ -77,19 +177,47 @@ namespace vmc
 
 		void initCommandBuffers();
 
-		void initFrameResources(const DescriptorSetLayout& mvpLayout);
+		void initFrameResources(const DescriptorSetLayout& mvpLayout, uint32_t framesInFlight);
 
-		void handleSurfaceChanges();
+		void handleSurfaceChanges(bool isOutOfDate);
 
-		void destroySwapchainResources();
+		void releaseRetiredResources(FrameResources& resource);
 
-		void initSwapchainResources();
+		void resetSecondaryCommandPools(FrameResources& resource);
+
+		FrameResources& getRetirementFrameResources();
+
+		void destroyRenderTargets();
+
+		void initRenderTargets();
 
 		bool isFrameStarted = false;
 
 		uint32_t currentImageIndex = 0;
 
-		void beginRecordingCommandBuffer(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkClearColorValue clearColor);
+		RenderPassMode currentRenderPassMode = RenderPassMode::Single;
+
+		RenderPassStage currentRenderPassStage = RenderPassStage::Complete;
+
+		const RenderPass* currentRenderPass = nullptr;
+
+		VkSubpassContents currentSubpassContents = VK_SUBPASS_CONTENTS_INLINE;
+
+		bool isRenderPassActive = false;
+
+		VkClearColorValue currentClearColor{};
+
+		void beginRecordingCommandBuffer(VkCommandBuffer commandBuffer);
+
+		void beginRenderPass(const RenderPass& pass, RenderPassStage stage);
+
+		void setViewportAndScissor(VkCommandBuffer commandBuffer);
+
+		VkFramebuffer getCurrentFramebuffer() const;
+
+		VkExtent2D getExtent() const;
+
+		void beginSecondaryCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags usage, VkFramebuffer framebuffer);
 
 		void endRecordingCommandBuffer(VkCommandBuffer commandBuffer);
 	};
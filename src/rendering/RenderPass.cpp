@@ -3,7 +3,7 @@
 
 namespace vmc
 {
-	RenderPass::RenderPass(VulkanDevice& device, VkFormat colorFormat) :
+	RenderPass::RenderPass(VulkanDevice& device, VkFormat colorFormat, RenderPassStage stage, VkImageLayout colorFinalLayout) :
 		device(device)
 	{
 		VkAttachmentDescription colorAttachment{};
@@ -12,7 +12,7 @@ namespace vmc
 		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colorAttachment.finalLayout = colorFinalLayout;
 
 		VkAttachmentDescription depthAttachment{};
 		depthAttachment.format = device.getDepthFormat();
@@ -22,6 +22,18 @@ namespace vmc
 		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
+		if (stage == RenderPassStage::Begin) {
+			colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		}
+		else if (stage == RenderPassStage::Resume) {
+			colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		}
+
 		VkAttachmentReference colorAttachmentReference{};
 		colorAttachmentReference.attachment = 0;
 		colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -43,6 +55,25 @@ namespace vmc
 		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
+		std::vector<VkSubpassDependency> dependencies = { dependency };
+
+		if (stage == RenderPassStage::Begin) {
+			// Depth written by this pass is read by compute work recorded between the two passes.
+			VkSubpassDependency depthReadDependency{};
+			depthReadDependency.srcSubpass = 0;
+			depthReadDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+			depthReadDependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			depthReadDependency.dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			depthReadDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			depthReadDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			dependencies.push_back(depthReadDependency);
+		}
+		else if (stage == RenderPassStage::Resume) {
+			dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			dependencies[0].dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			dependencies[0].dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		}
+
 		std::vector<VkAttachmentDescription> attachments = { colorAttachment , depthAttachment };
 
 		VkRenderPassCreateInfo createInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
@@ -50,8 +81,8 @@ namespace vmc
 		createInfo.pAttachments = attachments.data();
 		createInfo.subpassCount = 1;
 		createInfo.pSubpasses = &subpass;
-		createInfo.dependencyCount = 1;
-		createInfo.pDependencies = &dependency;
+		createInfo.dependencyCount = dependencies.size();
+		createInfo.pDependencies = dependencies.data();
 
 		if (vkCreateRenderPass(device.getHandle(), &createInfo, nullptr, &handle) != VK_SUCCESS) {
 			throw std::runtime_error("Cannot create renderpass.");
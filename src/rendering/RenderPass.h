@@ -4,10 +4,20 @@
 
 namespace vmc
 {
+	// A frame is either recorded in one Complete pass, or split into a Begin pass that leaves the depth buffer readable
+	// and a Resume pass that loads both attachments and finishes for presentation. All stages are render pass compatible.
+	// Offscreen frames finish in a copyable layout instead of the presentable one.
+	enum class RenderPassStage
+	{
+		Complete,
+		Begin,
+		Resume
+	};
+
 	class RenderPass
 	{
 	public:
-		RenderPass(VulkanDevice& device, VkFormat colorFormat);
+		RenderPass(VulkanDevice& device, VkFormat colorFormat, RenderPassStage stage = RenderPassStage::Complete, VkImageLayout colorFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
 		RenderPass(const RenderPass&) = delete;
 
@@ -42,12 +42,12 @@ namespace vmc
 		rasterizer.rasterizerDiscardEnable = VK_FALSE;
 		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
 		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_NONE;
+		rasterizer.cullMode = description.cullMode;
 		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 
 		VkPipelineDepthStencilStateCreateInfo depthInfo{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
-		depthInfo.depthTestEnable = VK_TRUE;
-		depthInfo.depthWriteEnable = VK_TRUE;
+		depthInfo.depthTestEnable = description.isDepthTestEnabled ? VK_TRUE : VK_FALSE;
+		depthInfo.depthWriteEnable = description.isDepthTestEnabled ? VK_TRUE : VK_FALSE;
 		depthInfo.depthCompareOp = VK_COMPARE_OP_LESS;
 		depthInfo.depthBoundsTestEnable = VK_FALSE;
 		depthInfo.stencilTestEnable = VK_FALSE;
@@ -60,6 +60,25 @@ namespace vmc
 		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 		colorBlendAttachment.blendEnable = VK_FALSE;
 
+		if (description.isAdditiveBlendingEnabled) {
+			colorBlendAttachment.blendEnable = VK_TRUE;
+			colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+			colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+			colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+			colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		}
+		else if (description.isAlphaBlendingEnabled) {
+			colorBlendAttachment.blendEnable = VK_TRUE;
+			colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+			colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+			colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		}
+
 		VkPipelineColorBlendStateCreateInfo colorBlending{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
 		colorBlending.logicOpEnable = VK_FALSE;
 		colorBlending.attachmentCount = 1;
@@ -68,6 +87,8 @@ namespace vmc
 		VkPipelineLayoutCreateInfo layoutCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
 		layoutCreateInfo.setLayoutCount = description.descriptorSetLayouts.size();
 		layoutCreateInfo.pSetLayouts = description.descriptorSetLayouts.data();
+		layoutCreateInfo.pushConstantRangeCount = description.pushConstantRanges.size();
+		layoutCreateInfo.pPushConstantRanges = description.pushConstantRanges.data();
 
 		if (vkCreatePipelineLayout(device.getHandle(), &layoutCreateInfo, nullptr, &layout) != VK_SUCCESS) {
 			throw std::runtime_error("Cannot create pipeline layout.");
@@ -88,7 +109,7 @@ namespace vmc
 		createInfo.renderPass = description.renderPass;
 		createInfo.subpass = description.subpass;
 
-		if (vkCreateGraphicsPipelines(device.getHandle(), VK_NULL_HANDLE, 1, &createInfo, nullptr, &handle) != VK_SUCCESS) {
+		if (vkCreateGraphicsPipelines(device.getHandle(), description.pipelineCache, 1, &createInfo, nullptr, &handle) != VK_SUCCESS) {
 			throw std::runtime_error("Cannot create pipeline.");
 		}
 	}
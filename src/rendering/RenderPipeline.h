@@ -11,8 +11,14 @@ namespace vmc
 		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
 		std::vector<VulkanShaderModule> shaderModules;
 		std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+		std::vector<VkPushConstantRange> pushConstantRanges;
 		VkRenderPass renderPass;
 		uint32_t subpass;
+		VkCullModeFlags cullMode = VK_CULL_MODE_NONE;
+		bool isAdditiveBlendingEnabled = false;
+		bool isAlphaBlendingEnabled = false;
+		bool isDepthTestEnabled = true;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 	};
 
 	class RenderPipeline
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vmc
+{
+    struct RenderStats
+    {
+        uint32_t visibleDraws = 0;
+        uint32_t culledDraws = 0;
+        uint32_t caveCulledDraws = 0;
+        uint32_t occlusionCulledDraws = 0;
+        uint32_t drawCalls = 0;
+        uint32_t recordedDraws = 0;
+        float inputLatencyMs = 0.0f;
+    };
+}
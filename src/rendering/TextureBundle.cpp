@@ -37,7 +37,7 @@ namespace vmc
 
     void TextureBundle::add(const std::string& name, const std::string& path, uint32_t mipLevels)
     {
-        Image rawImage("data/images/main_atlas.png");
+        Image rawImage(path);
 
         auto usageFlags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
         if (mipLevels > 1) {
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform ViewProjection
+{
+    mat4 data;
+} viewProjection;
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inUv;
+layout(location = 2) in vec4 inChunkOffset;
+
+layout(location = 0) out vec2 fragUv;
+layout(location = 1) out float illuminance;
+
+void main() {
+    gl_Position = viewProjection.data * vec4(inPosition.xyz + inChunkOffset.xyz, 1.0);
+    fragUv = inUv;
+	illuminance = inPosition.w;
+}
@@ -1,10 +1,15 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(set = 0, binding = 0) uniform MVP
+layout(set = 0, binding = 0) uniform ViewProjection
 {
     mat4 data;
-} mvp;
+} viewProjection;
+
+layout(push_constant) uniform ChunkParameters
+{
+    ivec4 offset;
+} chunk;
 
 layout(location = 0) in vec4 inPosition;
 layout(location = 1) in vec2 inUv;
@@ -13,7 +18,7 @@ layout(location = 0) out vec2 fragUv;
 layout(location = 1) out float illuminance;
 
 void main() {
-    gl_Position = mvp.data * vec4(inPosition.xyz, 1.0);
+    gl_Position = viewProjection.data * vec4(inPosition.xyz + vec3(chunk.offset.xyz), 1.0);
     fragUv = inUv;
 	illuminance = inPosition.w;
 }
\ No newline at end of file
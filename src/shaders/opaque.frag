@@ -0,0 +1,13 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 1, binding = 0) uniform sampler2D tex;
+
+layout(location = 0) in vec2 fragUv;
+layout(location = 1) in float illuminance;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(tex, fragUv) * illuminance;
+}
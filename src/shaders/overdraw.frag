@@ -0,0 +1,12 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 fragUv;
+layout(location = 1) in float illuminance;
+
+layout(location = 0) out vec4 outColor;
+
+// Every fragment that survives the depth test adds a fixed amount, so the brightness of a pixel counts how often it was shaded.
+void main() {
+    outColor = vec4(0.1, 0.05, 0.02, 1.0);
+}
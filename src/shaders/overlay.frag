@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform sampler2D font;
+
+layout(location = 0) in vec2 fragUv;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Glyph texels are white, the magenta background and the grey cells of missing glyphs are left transparent.
+    float coverage = 1.0;
+    if (fragUv.x >= 0.0) {
+        coverage = step(0.99, texture(font, fragUv).g);
+    }
+
+    outColor = vec4(fragColor.rgb, fragColor.a * coverage);
+}
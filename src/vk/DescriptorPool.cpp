@@ -3,7 +3,7 @@
 
 namespace vmc
 {
-	DescriptorPool::DescriptorPool(const VulkanDevice& device, uint32_t uniformCount, uint32_t uniformDynamicCount, uint32_t texturesCount, uint32_t setCount) :
+	DescriptorPool::DescriptorPool(const VulkanDevice& device, uint32_t uniformCount, uint32_t uniformDynamicCount, uint32_t texturesCount, uint32_t setCount, VkDescriptorPoolCreateFlags flags) :
 		device(device)
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes;
@@ -29,7 +29,19 @@ namespace vmc
 			poolSizes.push_back(poolSize);
 		}
 
+		init(poolSizes, setCount, flags);
+	}
+
+	DescriptorPool::DescriptorPool(const VulkanDevice& device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t setCount, VkDescriptorPoolCreateFlags flags) :
+		device(device)
+	{
+		init(poolSizes, setCount, flags);
+	}
+
+	void DescriptorPool::init(const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t setCount, VkDescriptorPoolCreateFlags flags)
+	{
 		VkDescriptorPoolCreateInfo createInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+		createInfo.flags = flags;
 		createInfo.maxSets = setCount;
 		createInfo.poolSizeCount = poolSizes.size();
 		createInfo.pPoolSizes = poolSizes.data();
@@ -61,4 +73,11 @@ namespace vmc
 
 		return descriptorSet;
 	}
+
+	void DescriptorPool::free(VkDescriptorSet descriptorSet)
+	{
+		if (vkFreeDescriptorSets(device.getHandle(), handle, 1, &descriptorSet) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot free descriptor set.");
+		}
+	}
 }
\ No newline at end of file
@@ -7,7 +7,9 @@ namespace vmc
 	class DescriptorPool
 	{
 	public:
-		DescriptorPool(const VulkanDevice& device, uint32_t uniformCount, uint32_t uniformDynamicCount, uint32_t texturesCount, uint32_t setCount);
+		DescriptorPool(const VulkanDevice& device, uint32_t uniformCount, uint32_t uniformDynamicCount, uint32_t texturesCount, uint32_t setCount, VkDescriptorPoolCreateFlags flags = 0);
+
+		DescriptorPool(const VulkanDevice& device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t setCount, VkDescriptorPoolCreateFlags flags = 0);
 
 		DescriptorPool(const DescriptorPool&) = delete;
 
@@ -21,9 +23,13 @@ namespace vmc
 
 		VkDescriptorSet allocate(VkDescriptorSetLayout layout);
 
+		void free(VkDescriptorSet descriptorSet);
+
 	private:
 		const VulkanDevice& device;
 
 		VkDescriptorPool handle = VK_NULL_HANDLE;
+
+		void init(const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t setCount, VkDescriptorPoolCreateFlags flags);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "GpuProfiler.h"
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+namespace vmc
+{
+	const float GpuTimingSmoothing = 0.1f;
+
+	GpuProfiler::GpuProfiler(const VulkanDevice& device, uint32_t slotCount, uint32_t scopeCapacity) :
+		device(device),
+		scopeCapacity(scopeCapacity)
+	{
+		timestampPeriodNs = device.getProperties().limits.timestampPeriod;
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, nullptr);
+
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+		// vkCmdResetQueryPool is only valid on graphics and compute queues, so dedicated transfer families are not timed.
+		for (const auto& queueFamily : queueFamilies) {
+			bool isResetSupported = (queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) != 0;
+			timestampValidBits.push_back(isResetSupported ? queueFamily.timestampValidBits : 0);
+		}
+
+		VkQueryPoolCreateInfo createInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+		createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		createInfo.queryCount = scopeCapacity * 2;
+
+		slots.resize(slotCount);
+		for (auto& slot : slots) {
+			if (vkCreateQueryPool(device.getHandle(), &createInfo, nullptr, &slot.queryPool) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot create query pool.");
+			}
+		}
+
+		// Every query carries its value followed by its availability.
+		results.resize(scopeCapacity * 4);
+	}
+
+	GpuProfiler::~GpuProfiler()
+	{
+		for (auto& slot : slots) {
+			if (slot.queryPool != VK_NULL_HANDLE) {
+				vkDestroyQueryPool(device.getHandle(), slot.queryPool, nullptr);
+			}
+		}
+	}
+
+	bool GpuProfiler::isSupported(uint32_t queueFamilyIndex) const
+	{
+		return timestampPeriodNs > 0.0f && queueFamilyIndex < timestampValidBits.size() && timestampValidBits[queueFamilyIndex] > 0;
+	}
+
+	void GpuProfiler::beginSlot(uint32_t slot)
+	{
+		currentSlot = slot;
+		readSlot(slots[slot]);
+	}
+
+	uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name, uint32_t queueFamilyIndex)
+	{
+		auto& slot = slots[currentSlot];
+		if (!isSupported(queueFamilyIndex) || slot.scopeNames.size() == scopeCapacity) {
+			return InvalidGpuScope;
+		}
+
+		uint32_t validBits = timestampValidBits[queueFamilyIndex];
+		uint32_t scope = (uint32_t)slot.scopeNames.size();
+		slot.scopeNames.push_back(name);
+		slot.timestampMasks.push_back(validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1);
+
+		vkCmdResetQueryPool(commandBuffer, slot.queryPool, scope * 2, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.queryPool, scope * 2);
+
+		// The handle names its slot as well, so a scope can still be ended after another slot has been begun.
+		return currentSlot * scopeCapacity + scope;
+	}
+
+	void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (scope == InvalidGpuScope) {
+			return;
+		}
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slots[scope / scopeCapacity].queryPool, (scope % scopeCapacity) * 2 + 1);
+	}
+
+	const std::vector<GpuTiming>& GpuProfiler::getTimings() const
+	{
+		return timings;
+	}
+
+	void GpuProfiler::readSlot(Slot& slot)
+	{
+		if (slot.scopeNames.empty()) {
+			return;
+		}
+
+		// Results are never waited for, a scope whose commands were not submitted is simply reported as unavailable.
+		uint32_t queryCount = (uint32_t)slot.scopeNames.size() * 2;
+		auto result = vkGetQueryPoolResults(device.getHandle(), slot.queryPool, 0, queryCount, queryCount * 2 * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		if (result == VK_SUCCESS || result == VK_NOT_READY) {
+			// Scopes recorded several times in one slot add up to a single sample.
+			slotSamples.clear();
+			for (uint32_t scope = 0; scope < slot.scopeNames.size(); scope++) {
+				const uint64_t* query = results.data() + scope * 4;
+				if (query[1] == 0 || query[3] == 0) {
+					continue;
+				}
+
+				uint64_t ticks = (query[2] - query[0]) & slot.timestampMasks[scope];
+				float ms = (float)(ticks * timestampPeriodNs / 1000000.0);
+
+				auto sample = std::find_if(slotSamples.begin(), slotSamples.end(), [&](const GpuTiming& timing) {
+					return strcmp(timing.name, slot.scopeNames[scope]) == 0;
+				});
+				if (sample != slotSamples.end()) {
+					sample->lastMs += ms;
+				}
+				else {
+					GpuTiming timing;
+					timing.name = slot.scopeNames[scope];
+					timing.lastMs = ms;
+					slotSamples.push_back(timing);
+				}
+			}
+
+			for (const auto& sample : slotSamples) {
+				addSample(sample.name, sample.lastMs);
+			}
+		}
+
+		slot.scopeNames.clear();
+		slot.timestampMasks.clear();
+	}
+
+	void GpuProfiler::addSample(const char* name, float ms)
+	{
+		for (auto& timing : timings) {
+			if (strcmp(timing.name, name) == 0) {
+				timing.lastMs = ms;
+				timing.averageMs = timing.averageMs + (ms - timing.averageMs) * GpuTimingSmoothing;
+				return;
+			}
+		}
+
+		// A new pass starts its average at its first sample instead of climbing up from zero.
+		GpuTiming timing;
+		timing.name = name;
+		timing.lastMs = ms;
+		timing.averageMs = ms;
+		timings.push_back(timing);
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vk/VulkanDevice.h>
+#include <vector>
+#include <cstdint>
+
+namespace vmc
+{
+	const uint32_t DefaultGpuScopeCapacity = 32;
+	const uint32_t InvalidGpuScope = UINT32_MAX;
+
+	struct GpuTiming
+	{
+		const char* name = nullptr;
+		float lastMs = 0.0f;
+		float averageMs = 0.0f;
+	};
+
+	// Timestamp queries around GPU work, with one query pool per slot. A slot is only begun again once the fence of the
+	// submissions that used it has been waited on, so its results are read back then without stalling. Every scope resets
+	// its own pair of queries in the command buffer that writes them, which keeps scopes recorded for different queues and
+	// submissions independent of each other, but leaves queue families without graphics or compute support unsupported.
+	// Scopes have to be recorded outside of render passes.
+	class GpuProfiler
+	{
+	public:
+		GpuProfiler(const VulkanDevice& device, uint32_t slotCount, uint32_t scopeCapacity = DefaultGpuScopeCapacity);
+
+		GpuProfiler(const GpuProfiler&) = delete;
+
+		GpuProfiler(GpuProfiler&& other) = delete;
+
+		~GpuProfiler();
+
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+		GpuProfiler& operator=(GpuProfiler&&) = delete;
+
+		bool isSupported(uint32_t queueFamilyIndex) const;
+
+		void beginSlot(uint32_t slot);
+
+		uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name, uint32_t queueFamilyIndex);
+
+		void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		const std::vector<GpuTiming>& getTimings() const;
+
+	private:
+		struct Slot
+		{
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			std::vector<const char*> scopeNames;
+			std::vector<uint64_t> timestampMasks;
+		};
+
+		const VulkanDevice& device;
+
+		std::vector<Slot> slots;
+
+		uint32_t currentSlot = 0;
+
+		uint32_t scopeCapacity;
+
+		float timestampPeriodNs = 0.0f;
+
+		std::vector<uint32_t> timestampValidBits;
+
+		std::vector<uint64_t> results;
+
+		std::vector<GpuTiming> timings;
+
+		std::vector<GpuTiming> slotSamples;
+
+		void readSlot(Slot& slot);
+
+		void addSample(const char* name, float ms);
+	};
+}
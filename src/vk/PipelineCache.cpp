@@ -0,0 +1,141 @@
+#include "PipelineCache.h"
+#include <common/Log.h>
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdio>
+
+namespace vmc
+{
+	const uint32_t PipelineCacheMagic = 0x50434d56;
+	const uint32_t PipelineCacheFileVersion = 1;
+
+	static uint64_t hashData(const std::vector<uint8_t>& data)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (auto byte : data) {
+			hash = (hash ^ byte) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	PipelineCache::PipelineCache(const VulkanDevice& device, const std::string& path) :
+		device(device),
+		path(path)
+	{
+		auto data = loadData();
+		hasLoadedData = !data.empty();
+
+		VkPipelineCacheCreateInfo createInfo{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+		if (vkCreatePipelineCache(device.getHandle(), &createInfo, nullptr, &handle) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot create pipeline cache.");
+		}
+	}
+
+	PipelineCache::~PipelineCache()
+	{
+		if (handle != VK_NULL_HANDLE) {
+			vkDestroyPipelineCache(device.getHandle(), handle, nullptr);
+		}
+	}
+
+	void PipelineCache::save()
+	{
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(device.getHandle(), handle, &dataSize, nullptr) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot get pipeline cache data.");
+		}
+
+		std::vector<uint8_t> data(dataSize);
+		if (vkGetPipelineCacheData(device.getHandle(), handle, &dataSize, data.data()) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot get pipeline cache data.");
+		}
+		data.resize(dataSize);
+
+		auto header = createHeader(data);
+
+		// The file is replaced only once it is complete, so an interrupted save never leaves a truncated cache behind.
+		auto temporaryPath = path + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+				loge("Cannot write pipeline cache %s.", temporaryPath.c_str());
+				return;
+			}
+
+			file.write((const char*)&header, sizeof(header));
+			file.write((const char*)data.data(), data.size());
+		}
+
+		std::remove(path.c_str());
+		if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+			loge("Cannot replace pipeline cache %s.", path.c_str());
+		}
+	}
+
+	VkPipelineCache PipelineCache::getHandle() const
+	{
+		return handle;
+	}
+
+	bool PipelineCache::isWarm() const
+	{
+		return hasLoadedData;
+	}
+
+	std::vector<uint8_t> PipelineCache::loadData() const
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			return {};
+		}
+
+		size_t fileSize = file.tellg();
+		if (fileSize < sizeof(PipelineCacheFileHeader)) {
+			logd("Ignoring truncated pipeline cache %s.", path.c_str());
+			return {};
+		}
+
+		PipelineCacheFileHeader header;
+		file.seekg(0);
+		file.read((char*)&header, sizeof(header));
+
+		std::vector<uint8_t> data(fileSize - sizeof(header));
+		file.read((char*)data.data(), data.size());
+
+		auto expectedHeader = createHeader(data);
+		if (header.magic != expectedHeader.magic || header.version != expectedHeader.version ||
+			header.vendorID != expectedHeader.vendorID || header.deviceID != expectedHeader.deviceID ||
+			header.driverVersion != expectedHeader.driverVersion ||
+			memcmp(header.pipelineCacheUUID, expectedHeader.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+			logd("Ignoring pipeline cache %s built for another device or driver.", path.c_str());
+			return {};
+		}
+
+		if (header.dataSize != data.size() || header.dataHash != expectedHeader.dataHash) {
+			logd("Ignoring corrupted pipeline cache %s.", path.c_str());
+			return {};
+		}
+
+		return data;
+	}
+
+	PipelineCacheFileHeader PipelineCache::createHeader(const std::vector<uint8_t>& data) const
+	{
+		const auto& properties = device.getProperties();
+
+		PipelineCacheFileHeader header{};
+		header.magic = PipelineCacheMagic;
+		header.version = PipelineCacheFileVersion;
+		header.vendorID = properties.vendorID;
+		header.deviceID = properties.deviceID;
+		header.driverVersion = properties.driverVersion;
+		memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = data.size();
+		header.dataHash = hashData(data);
+		return header;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vk/VulkanDevice.h>
+#include <string>
+
+namespace vmc
+{
+	// Written in front of the driver's cache data. The driver validates its own header as well, but it does not include
+	// the driver version, and a cache built by an older driver is at best useless.
+	struct PipelineCacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t dataHash;
+	};
+
+	class PipelineCache
+	{
+	public:
+		PipelineCache(const VulkanDevice& device, const std::string& path);
+
+		PipelineCache(const PipelineCache&) = delete;
+
+		PipelineCache(PipelineCache&& other) = delete;
+
+		~PipelineCache();
+
+		PipelineCache& operator=(const PipelineCache&) = delete;
+
+		PipelineCache& operator=(PipelineCache&&) = delete;
+
+		void save();
+
+		VkPipelineCache getHandle() const;
+
+		bool isWarm() const;
+
+	private:
+		const VulkanDevice& device;
+
+		std::string path;
+
+		VkPipelineCache handle = VK_NULL_HANDLE;
+
+		bool hasLoadedData = false;
+
+		std::vector<uint8_t> loadData() const;
+
+		PipelineCacheFileHeader createHeader(const std::vector<uint8_t>& data) const;
+	};
+}
@@ -1,11 +1,23 @@
 #include "StagingManager.h"
+#include <common/Profiler.h>
 #include <stdexcept>
+#include <cstring>
+#include <algorithm>
 
 namespace vmc
 {
-	StagingManager::StagingManager(const VulkanDevice& device, VkDeviceSize size) :
-		stagingBuffer(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY),
-		device(device)
+	const VkDeviceSize StagingAlignment = 16;
+
+	static VkDeviceSize alignStagingOffset(VkDeviceSize offset)
+	{
+		return (offset + StagingAlignment - 1) & ~(StagingAlignment - 1);
+	}
+
+	StagingManager::StagingManager(const VulkanDevice& device, VkDeviceSize blockSize, VkDeviceSize maxMemory) :
+		device(device),
+		gpuProfiler(device, MaxStagingBatchesInFlight + 1),
+		blockSize(blockSize),
+		maxMemory(std::max(blockSize, maxMemory))
 	{
 		VkCommandPoolCreateInfo poolCreateInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
 		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
@@ -20,27 +32,82 @@ namespace vmc
             throw std::runtime_error("Cannot create command pool.");
         }
 
+		if (vkCreateCommandPool(device.getHandle(), &poolCreateInfo, nullptr, &acquireCommandPool) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot create command pool.");
+		}
+
 		VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
-		allocateInfo.commandPool = commandPool;
+		allocateInfo.commandPool = graphicsCommandPool;
 		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 		allocateInfo.commandBufferCount = 1;
 
-		if (vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &commandBuffer) != VK_SUCCESS) {
-			throw std::runtime_error("Cannot allocate command buffer.");
-		}
-
-        allocateInfo.commandPool = graphicsCommandPool;
         if (vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &graphicsCommandBuffer) != VK_SUCCESS) {
             throw std::runtime_error("Cannot allocate command buffer.");
         }
+
+		VkFenceCreateInfo fenceCreateInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		if (vkCreateFence(device.getHandle(), &fenceCreateInfo, nullptr, &graphicsFence) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot create fence.");
+		}
+
+		VkSemaphoreCreateInfo semaphoreCreateInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+
+		batches.resize(MaxStagingBatchesInFlight);
+		for (auto& batch : batches) {
+			allocateInfo.commandPool = commandPool;
+			if (vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &batch.commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot allocate command buffer.");
+			}
+
+			allocateInfo.commandPool = acquireCommandPool;
+			if (vkAllocateCommandBuffers(device.getHandle(), &allocateInfo, &batch.acquireCommandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot allocate command buffer.");
+			}
+
+			if (vkCreateSemaphore(device.getHandle(), &semaphoreCreateInfo, nullptr, &batch.transferFinishedSemaphore) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot create semaphore.");
+			}
+
+			if (vkCreateFence(device.getHandle(), &fenceCreateInfo, nullptr, &batch.fence) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot create fence.");
+			}
+		}
+
+		currentBlock = createBlock(blockSize);
 	}
 
 	StagingManager::~StagingManager()
 	{
+		for (auto& batch : batches) {
+			if (batch.fence != VK_NULL_HANDLE) {
+				vkWaitForFences(device.getHandle(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+				vkDestroyFence(device.getHandle(), batch.fence, nullptr);
+			}
+
+			if (batch.transferFinishedSemaphore != VK_NULL_HANDLE) {
+				vkDestroySemaphore(device.getHandle(), batch.transferFinishedSemaphore, nullptr);
+			}
+		}
+
+		if (graphicsFence != VK_NULL_HANDLE) {
+			vkWaitForFences(device.getHandle(), 1, &graphicsFence, VK_TRUE, UINT64_MAX);
+			vkDestroyFence(device.getHandle(), graphicsFence, nullptr);
+		}
+
+		for (auto& block : blocks) {
+			block->buffer.unmap();
+		}
+
 		if (commandPool != VK_NULL_HANDLE) {
 			vkDestroyCommandPool(device.getHandle(), commandPool, nullptr);
 		}
 
+		if (acquireCommandPool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(device.getHandle(), acquireCommandPool, nullptr);
+		}
+
         if (graphicsCommandPool != VK_NULL_HANDLE) {
             vkDestroyCommandPool(device.getHandle(), graphicsCommandPool, nullptr);
         }
@@ -48,33 +115,33 @@ namespace vmc
 
 	void StagingManager::copyToBuffer(const void* data, VulkanBuffer& buffer, VkDeviceSize offset, VkDeviceSize size)
 	{
-		if (currentOffset + size > stagingBuffer.getSize()) {
-			throw std::runtime_error("Staging buffer is too small.");
-		}
-
-		stagingBuffer.copyFrom(data, currentOffset, size);
+		VMC_PROFILE_ZONE("stage buffer");
+		StagingBlock* block = nullptr;
+		VkDeviceSize stagingOffset = allocateStagingMemory(size, block);
+		memcpy(block->data + stagingOffset, data, size);
+		block->buffer.flush(stagingOffset, size);
 
 		VkBufferCopy region;
 		region.size = size;
 		region.dstOffset = offset;
-		region.srcOffset = currentOffset;
-		vkCmdCopyBuffer(commandBuffer, stagingBuffer.getHandle(), buffer.getHandle(), 1, &region);
+		region.srcOffset = stagingOffset;
+		vkCmdCopyBuffer(getCurrentBatch().commandBuffer, block->buffer.getHandle(), buffer.getHandle(), 1, &region);
 
-		currentOffset += size;
+		releaseBuffer(buffer, offset, size);
 	}
 
     void StagingManager::copyToImage(const void* data, VulkanImage& image, VkImageLayout finalLayout)
     {
-		VkDeviceSize size = image.getWidth() * image.getWidth() * 4;
-
-		if (currentOffset + size > stagingBuffer.getSize()) {
-			throw std::runtime_error("Staging buffer is too small.");
-		}
+        VMC_PROFILE_ZONE("stage image");
+		VkDeviceSize size = (VkDeviceSize)image.getWidth() * image.getHeight() * 4;
 
-		stagingBuffer.copyFrom(data, currentOffset, size);
+		StagingBlock* block = nullptr;
+		VkDeviceSize stagingOffset = allocateStagingMemory(size, block);
+		memcpy(block->data + stagingOffset, data, size);
+		block->buffer.flush(stagingOffset, size);
 
 		VkBufferImageCopy region{};
-		region.bufferOffset = currentOffset;
+		region.bufferOffset = stagingOffset;
 		region.bufferRowLength = 0;
 		region.bufferImageHeight = 0;
 
@@ -85,14 +152,13 @@ namespace vmc
 
 		region.imageOffset = { 0, 0, 0 };
 		region.imageExtent.width = image.getWidth();
-		region.imageExtent.height = image.getWidth();
+		region.imageExtent.height = image.getHeight();
 		region.imageExtent.depth = 1;
 
+		auto commandBuffer = getCurrentBatch().commandBuffer;
 		addLayoutTransition(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.getHandle(), image.getHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-        if (finalLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-            addLayoutTransition(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout);
-        }
+		vkCmdCopyBufferToImage(commandBuffer, block->buffer.getHandle(), image.getHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+		releaseImage(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout);
     }
 
     void StagingManager::generateMipmap(VulkanImage& image)
@@ -109,11 +175,13 @@ namespace vmc
         int32_t mipWidth = image.getWidth();
         int32_t mipHeight = image.getHeight();
 
+        auto gpuScope = gpuProfiler.beginScope(graphicsCommandBuffer, "mipmap", device.getGraphicsQueueFamilyIndex());
+
         for (uint32_t i = 1; i < image.getMipLevels(); i++) {
             barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
             barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
             barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
             barrier.subresourceRange.baseMipLevel = i - 1;
 
             vkCmdPipelineBarrier(graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
@@ -125,7 +193,7 @@ namespace vmc
             blit.srcSubresource.baseArrayLayer = 0;
             blit.srcSubresource.layerCount = 1;
             blit.srcSubresource.mipLevel = i - 1;
-            
+
             mipWidth /= 2;
             mipHeight /= 2;
 
@@ -142,40 +210,144 @@ namespace vmc
         barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
         barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
         barrier.subresourceRange.baseMipLevel = image.getMipLevels() - 1;
 
         vkCmdPipelineBarrier(graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
         addLayoutTransition(graphicsCommandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        gpuProfiler.endScope(graphicsCommandBuffer, gpuScope);
     }
 
+
     void StagingManager::start()
     {
-        vkResetCommandBuffer(commandBuffer, 0);
+		if (isBatchStarted) {
+			throw std::runtime_error("Staging batch is already started.");
+		}
+
+		beginBatch();
+    }
+
+	uint64_t StagingManager::flush()
+	{
+		auto batchId = getCurrentBatch().id;
+		submitBatch();
+		return batchId;
+	}
+
+	void StagingManager::beginBatch()
+	{
+		auto& batch = batches[currentBatchIndex];
+		if (batch.isPending) {
+			stats.stallsThisFrame++;
+			stats.totalStalls++;
+		}
+
+		{
+			VMC_PROFILE_ZONE("staging stall");
+			while (batch.isPending) {
+				retireOldestBatch(true);
+			}
+		}
+
+		batch.id = nextBatchId++;
+		batch.bufferReleaseBarriers.clear();
+		batch.bufferAcquireBarriers.clear();
+		batch.imageReleaseBarriers.clear();
+		batch.imageAcquireBarriers.clear();
+
+		vkResetCommandBuffer(batch.commandBuffer, 0);
 
         VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-        vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    }
+		vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+		isBatchStarted = true;
+
+		// On a dedicated transfer queue the scope is invalid and the upload goes untimed.
+		gpuProfiler.beginSlot(currentBatchIndex);
+		batch.gpuScope = gpuProfiler.beginScope(batch.commandBuffer, "upload", device.getTransferQueueFamilyIndex());
+	}
 
-	void StagingManager::flush()
+	void StagingManager::submitBatch()
 	{
-		vkEndCommandBuffer(commandBuffer);
+		VMC_PROFILE_ZONE("submit staging batch");
+		auto& batch = getCurrentBatch();
+		bool ownershipTransfer = isOwnershipTransferRequired();
+
+		if (!batch.bufferReleaseBarriers.empty() || !batch.imageReleaseBarriers.empty()) {
+			vkCmdPipelineBarrier(batch.commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				ownershipTransfer ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				0,
+				0, nullptr,
+				(uint32_t)batch.bufferReleaseBarriers.size(), batch.bufferReleaseBarriers.data(),
+				(uint32_t)batch.imageReleaseBarriers.size(), batch.imageReleaseBarriers.data());
+		}
+
+		gpuProfiler.endScope(batch.commandBuffer, batch.gpuScope);
+		vkEndCommandBuffer(batch.commandBuffer);
+		vkResetFences(device.getHandle(), 1, &batch.fence);
 
 		VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+		if (!ownershipTransfer) {
+			if (vkQueueSubmit(device.getTransferQueue(), 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot submit staging command buffer.");
+			}
+		}
+		else {
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &batch.transferFinishedSemaphore;
+
+			if (vkQueueSubmit(device.getTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot submit staging command buffer.");
+			}
+
+			vkResetCommandBuffer(batch.acquireCommandBuffer, 0);
+
+			VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+			vkBeginCommandBuffer(batch.acquireCommandBuffer, &beginInfo);
+			if (!batch.bufferAcquireBarriers.empty() || !batch.imageAcquireBarriers.empty()) {
+				vkCmdPipelineBarrier(batch.acquireCommandBuffer,
+					VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+					VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+					0,
+					0, nullptr,
+					(uint32_t)batch.bufferAcquireBarriers.size(), batch.bufferAcquireBarriers.data(),
+					(uint32_t)batch.imageAcquireBarriers.size(), batch.imageAcquireBarriers.data());
+			}
+			vkEndCommandBuffer(batch.acquireCommandBuffer);
+
+			VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+			VkSubmitInfo acquireSubmitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			acquireSubmitInfo.waitSemaphoreCount = 1;
+			acquireSubmitInfo.pWaitSemaphores = &batch.transferFinishedSemaphore;
+			acquireSubmitInfo.pWaitDstStageMask = &waitStage;
+			acquireSubmitInfo.commandBufferCount = 1;
+			acquireSubmitInfo.pCommandBuffers = &batch.acquireCommandBuffer;
+
+			if (vkQueueSubmit(device.getGraphicsQueue(), 1, &acquireSubmitInfo, batch.fence) != VK_SUCCESS) {
+				throw std::runtime_error("Cannot submit staging command buffer.");
+			}
+		}
 
-		vkQueueSubmit(device.getTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(device.getTransferQueue());
+		batch.isPending = true;
 
-		currentOffset = 0;
+		isBatchStarted = false;
+		currentBatchIndex = (currentBatchIndex + 1) % MaxStagingBatchesInFlight;
 	}
 
     void StagingManager::startGraphics()
     {
+		vkWaitForFences(device.getHandle(), 1, &graphicsFence, VK_TRUE, UINT64_MAX);
+		gpuProfiler.beginSlot(MaxStagingBatchesInFlight);
         vkResetCommandBuffer(graphicsCommandBuffer, 0);
 
         VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
@@ -187,14 +359,292 @@ namespace vmc
     void StagingManager::flushGraphics()
     {
         vkEndCommandBuffer(graphicsCommandBuffer);
+		vkResetFences(device.getHandle(), 1, &graphicsFence);
 
         VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &graphicsCommandBuffer;
 
-        vkQueueSubmit(device.getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(device.getGraphicsQueue());
-    } 
+		if (vkQueueSubmit(device.getGraphicsQueue(), 1, &submitInfo, graphicsFence) != VK_SUCCESS) {
+			throw std::runtime_error("Cannot submit staging command buffer.");
+		}
+    }
+
+
+	void StagingManager::update()
+	{
+		VMC_PROFILE_ZONE("update staging");
+		while (retireOldestBatch(false));
+
+		releaseIdleBlocks();
+
+		stats.bytesStagedLastFrame = stats.bytesStagedThisFrame;
+		stats.bytesStagedThisFrame = 0;
+		stats.stallsLastFrame = stats.stallsThisFrame;
+		stats.stallsThisFrame = 0;
+		frameIndex++;
+	}
+
+	bool StagingManager::isCompleted(uint64_t batchId) const
+	{
+		return batchId <= completedBatchId;
+	}
+
+	const StagingStats& StagingManager::getStats() const
+	{
+		return stats;
+	}
+
+	const std::vector<GpuTiming>& StagingManager::getGpuTimings() const
+	{
+		return gpuProfiler.getTimings();
+	}
+
+	bool StagingManager::isOwnershipTransferRequired() const
+	{
+		return device.getTransferQueueFamilyIndex() != device.getGraphicsQueueFamilyIndex();
+	}
+
+
+	StagingBatch& StagingManager::getCurrentBatch()
+	{
+		if (!isBatchStarted) {
+			throw std::runtime_error("Staging batch is not started.");
+		}
+
+		return batches[currentBatchIndex];
+	}
+
+	VkDeviceSize StagingManager::allocateStagingMemory(VkDeviceSize size, StagingBlock*& block)
+	{
+		uint64_t batchId = getCurrentBatch().id;
+		VkDeviceSize offset = 0;
+		bool isStalled = false;
+
+		while (true) {
+			if (tryAllocateFromBlock(*currentBlock, size, offset)) {
+				break;
+			}
+
+			auto freeBlock = findFreeBlock(size);
+			if (freeBlock == nullptr && stats.allocatedBytes + std::max(size, blockSize) <= maxMemory) {
+				freeBlock = createBlock(std::max(size, blockSize));
+			}
+
+			if (freeBlock != nullptr) {
+				// Oversized blocks are dedicated to a single copy, so the current block keeps serving small copies.
+				if (freeBlock->buffer.getSize() > blockSize) {
+					tryAllocateFromBlock(*freeBlock, size, offset);
+					block = freeBlock;
+					block->lastBatchId = batchId;
+					block->lastUsedFrame = frameIndex;
+					stats.bytesStagedThisFrame += size;
+					return offset;
+				}
+
+				currentBlock = freeBlock;
+				continue;
+			}
+
+			if (!isStalled) {
+				isStalled = true;
+				stats.stallsThisFrame++;
+				stats.totalStalls++;
+			}
+
+			if (retireOldestBatch(true)) {
+				continue;
+			}
+
+			if (currentBlock->lastBatchId == batchId) {
+				// Everything in flight belongs to the batch being recorded, so submit what it has so far and continue in a new batch.
+				submitBatch();
+				beginBatch();
+				batchId = getCurrentBatch().id;
+				continue;
+			}
+
+			// Staging memory is exhausted by this copy alone, so allocate past the limit rather than fail.
+			currentBlock = createBlock(std::max(size, blockSize));
+		}
+
+		currentBlock->lastBatchId = batchId;
+		currentBlock->lastUsedFrame = frameIndex;
+		block = currentBlock;
+		stats.bytesStagedThisFrame += size;
+
+		return offset;
+	}
+
+	bool StagingManager::tryAllocateFromBlock(StagingBlock& block, VkDeviceSize size, VkDeviceSize& offset)
+	{
+		if (!isBlockInUse(block)) {
+			block.offset = 0;
+		}
+
+		VkDeviceSize alignedOffset = alignStagingOffset(block.offset);
+		if (alignedOffset + size > block.buffer.getSize()) {
+			return false;
+		}
+
+		offset = alignedOffset;
+		block.offset = alignedOffset + size;
+
+		return true;
+	}
+
+	StagingBlock* StagingManager::findFreeBlock(VkDeviceSize size)
+	{
+		StagingBlock* bestBlock = nullptr;
+
+		for (auto& block : blocks) {
+			if (block.get() == currentBlock || isBlockInUse(*block) || block->buffer.getSize() < size) {
+				continue;
+			}
+
+			if (bestBlock == nullptr || block->buffer.getSize() < bestBlock->buffer.getSize()) {
+				bestBlock = block.get();
+			}
+		}
+
+		return bestBlock;
+	}
+
+	StagingBlock* StagingManager::createBlock(VkDeviceSize size)
+	{
+		auto block = std::make_unique<StagingBlock>(StagingBlock{ VulkanBuffer(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY) });
+		block->data = (uint8_t*)block->buffer.map();
+		block->lastUsedFrame = frameIndex;
+
+		stats.blockCount++;
+		stats.allocatedBytes += size;
+
+		blocks.push_back(std::move(block));
+		return blocks.back().get();
+	}
+
+	bool StagingManager::isBlockInUse(const StagingBlock& block) const
+	{
+		if (block.lastBatchId == 0) {
+			return false;
+		}
+
+		if (isBatchStarted && block.lastBatchId == batches[currentBatchIndex].id) {
+			return true;
+		}
+
+		return block.lastBatchId > completedBatchId;
+	}
+
+	void StagingManager::releaseIdleBlocks()
+	{
+		for (auto it = blocks.begin(); it != blocks.end();) {
+			auto& block = *it;
+			bool isOversized = block->buffer.getSize() > blockSize;
+			uint32_t idleFrames = isOversized ? 1 : StagingBlockIdleFrames;
+
+			if (block.get() == currentBlock || isBlockInUse(*block) || frameIndex - block->lastUsedFrame < idleFrames) {
+				++it;
+				continue;
+			}
+
+			stats.blockCount--;
+			stats.allocatedBytes -= block->buffer.getSize();
+			block->buffer.unmap();
+			it = blocks.erase(it);
+		}
+	}
+
+	bool StagingManager::retireOldestBatch(bool wait)
+	{
+		StagingBatch* oldestBatch = nullptr;
+		for (auto& batch : batches) {
+			if (batch.isPending && (oldestBatch == nullptr || batch.id < oldestBatch->id)) {
+				oldestBatch = &batch;
+			}
+		}
+
+		if (oldestBatch == nullptr) {
+			return false;
+		}
+
+		if (wait) {
+			vkWaitForFences(device.getHandle(), 1, &oldestBatch->fence, VK_TRUE, UINT64_MAX);
+		}
+		else if (vkGetFenceStatus(device.getHandle(), oldestBatch->fence) != VK_SUCCESS) {
+			return false;
+		}
+
+		oldestBatch->isPending = false;
+		completedBatchId = oldestBatch->id;
+
+		return true;
+	}
+
+	void StagingManager::releaseBuffer(VulkanBuffer& buffer, VkDeviceSize offset, VkDeviceSize size)
+	{
+		auto& batch = getCurrentBatch();
+
+		VkBufferMemoryBarrier barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+		barrier.buffer = buffer.getHandle();
+		barrier.offset = offset;
+		barrier.size = size;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		if (isOwnershipTransferRequired()) {
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = device.getTransferQueueFamilyIndex();
+			barrier.dstQueueFamilyIndex = device.getGraphicsQueueFamilyIndex();
+			batch.bufferReleaseBarriers.push_back(barrier);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			batch.bufferAcquireBarriers.push_back(barrier);
+		}
+		else {
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			batch.bufferReleaseBarriers.push_back(barrier);
+		}
+	}
+
+	void StagingManager::releaseImage(VulkanImage& image, VkImageLayout oldLayout, VkImageLayout newLayout)
+	{
+		auto& batch = getCurrentBatch();
+
+		VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.image = image.getHandle();
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = image.getMipLevels();
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		VkAccessFlags dstAccessMask = newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ?
+			VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT :
+			VK_ACCESS_SHADER_READ_BIT;
+
+		if (isOwnershipTransferRequired()) {
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = device.getTransferQueueFamilyIndex();
+			barrier.dstQueueFamilyIndex = device.getGraphicsQueueFamilyIndex();
+			batch.imageReleaseBarriers.push_back(barrier);
+
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = dstAccessMask;
+			batch.imageAcquireBarriers.push_back(barrier);
+		}
+		else {
+			barrier.dstAccessMask = dstAccessMask;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			batch.imageReleaseBarriers.push_back(barrier);
+		}
+	}
 
 	void StagingManager::addLayoutTransition(VkCommandBuffer commandBuffer, VulkanImage& image, VkImageLayout oldLayout, VkImageLayout newLayout)
 	{
@@ -220,19 +670,23 @@ namespace vmc
 		}
 		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
 			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 		}
         else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
             barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
             sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
         }
 
 		vkCmdPipelineBarrier(commandBuffer,
 			sourceStage,
 			destinationStage,
 			0,
-			0, nullptr, 
+			0, nullptr,
 			0, nullptr,
 			1, &barrier);
 	}
-}
\ No newline at end of file
+}
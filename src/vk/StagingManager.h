@@ -2,15 +2,56 @@
 
 #include <vk/VulkanBuffer.h>
 #include <vk/VulkanImage.h>
+#include <vk/GpuProfiler.h>
+#include <vector>
+#include <memory>
 
 namespace vmc
 {
-	const VkDeviceSize DefaultStagingBufferSize = 32 * 1024 * 1024;
+	const VkDeviceSize DefaultStagingBlockSize = 8 * 1024 * 1024;
+	const VkDeviceSize MaxStagingMemory = 128 * 1024 * 1024;
+	const uint32_t MaxStagingBatchesInFlight = 4;
+	const uint32_t StagingBlockIdleFrames = 120;
+
+	struct StagingBlock
+	{
+		VulkanBuffer buffer;
+		uint8_t* data = nullptr;
+		VkDeviceSize offset = 0;
+		uint64_t lastBatchId = 0;
+		uint64_t lastUsedFrame = 0;
+	};
+
+	struct StagingBatch
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+		VkSemaphore transferFinishedSemaphore = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		uint64_t id = 0;
+		uint32_t gpuScope = InvalidGpuScope;
+		bool isPending = false;
+		std::vector<VkBufferMemoryBarrier> bufferReleaseBarriers;
+		std::vector<VkBufferMemoryBarrier> bufferAcquireBarriers;
+		std::vector<VkImageMemoryBarrier> imageReleaseBarriers;
+		std::vector<VkImageMemoryBarrier> imageAcquireBarriers;
+	};
+
+	struct StagingStats
+	{
+		VkDeviceSize bytesStagedThisFrame = 0;
+		VkDeviceSize bytesStagedLastFrame = 0;
+		uint32_t stallsThisFrame = 0;
+		uint32_t stallsLastFrame = 0;
+		uint64_t totalStalls = 0;
+		uint32_t blockCount = 0;
+		VkDeviceSize allocatedBytes = 0;
+	};
 
 	class StagingManager
 	{
 	public:
-		StagingManager(const VulkanDevice& device, VkDeviceSize size = DefaultStagingBufferSize);
+		StagingManager(const VulkanDevice& device, VkDeviceSize blockSize = DefaultStagingBlockSize, VkDeviceSize maxMemory = MaxStagingMemory);
 
 		StagingManager(const StagingManager&) = delete;
 
@@ -28,7 +69,7 @@ namespace vmc
 
 		void copyToImage(const void* data, VulkanImage& image, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-		void flush();
+		uint64_t flush();
 
         void startGraphics();
 
@@ -36,21 +77,78 @@ namespace vmc
 
         void flushGraphics();
 
+		void update();
+
+		bool isCompleted(uint64_t batchId) const;
+
+		const StagingStats& getStats() const;
+
+		const std::vector<GpuTiming>& getGpuTimings() const;
+
 	private:
 		const VulkanDevice& device;
 
-		VulkanBuffer stagingBuffer;
+		// One slot per staging batch, followed by the slot of the graphics command buffer.
+		GpuProfiler gpuProfiler;
+
+		VkDeviceSize blockSize;
 
-		VkDeviceSize currentOffset = 0;
+		VkDeviceSize maxMemory;
+
+		std::vector<std::unique_ptr<StagingBlock>> blocks;
+
+		StagingBlock* currentBlock = nullptr;
+
+		StagingStats stats;
+
+		uint64_t frameIndex = 0;
 
 		VkCommandPool commandPool = VK_NULL_HANDLE;
 
-		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkCommandPool acquireCommandPool = VK_NULL_HANDLE;
 
         VkCommandPool graphicsCommandPool = VK_NULL_HANDLE;
 
         VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
 
+		VkFence graphicsFence = VK_NULL_HANDLE;
+
+		std::vector<StagingBatch> batches;
+
+		uint32_t currentBatchIndex = 0;
+
+		uint64_t nextBatchId = 1;
+
+		uint64_t completedBatchId = 0;
+
+		bool isBatchStarted = false;
+
+		bool isOwnershipTransferRequired() const;
+
+		StagingBatch& getCurrentBatch();
+
+		void beginBatch();
+
+		void submitBatch();
+
+		VkDeviceSize allocateStagingMemory(VkDeviceSize size, StagingBlock*& block);
+
+		bool tryAllocateFromBlock(StagingBlock& block, VkDeviceSize size, VkDeviceSize& offset);
+
+		StagingBlock* findFreeBlock(VkDeviceSize size);
+
+		StagingBlock* createBlock(VkDeviceSize size);
+
+		bool isBlockInUse(const StagingBlock& block) const;
+
+		void releaseIdleBlocks();
+
+		bool retireOldestBatch(bool wait);
+
+		void releaseBuffer(VulkanBuffer& buffer, VkDeviceSize offset, VkDeviceSize size);
+
+		void releaseImage(VulkanImage& image, VkImageLayout oldLayout, VkImageLayout newLayout);
+
 		void addLayoutTransition(VkCommandBuffer commandBuffer, VulkanImage& image, VkImageLayout oldLayout, VkImageLayout newLayout);
 	};
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #include "Swapchain.h"
 #include "common/Utils.h"
+#include "common/Log.h"
 #include <stdexcept>
 
 namespace vmc
@@ -14,14 +15,15 @@ namespace vmc
 		return presentModes;
 	}
 
-	VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR>& availableModes)
+	VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR>& availableModes, VkPresentModeKHR preferredMode)
 	{
 		for (const auto& mode : availableModes) {
-			if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
+			if (mode == preferredMode) {
 				return mode;
 			}
 		}
 
+		// FIFO is the only mode every implementation has to support.
 		return VK_PRESENT_MODE_FIFO_KHR;
 	}
 
@@ -38,7 +40,7 @@ namespace vmc
 		return extent;
 	}
 
-	VulkanSwapchain::VulkanSwapchain(const VulkanDevice& device, VkSurfaceFormatKHR surfaceFormat, VkSurfaceKHR surface, uint32_t width, uint32_t height) :
+	VulkanSwapchain::VulkanSwapchain(const VulkanDevice& device, VkSurfaceFormatKHR surfaceFormat, VkSurfaceKHR surface, uint32_t width, uint32_t height, VkPresentModeKHR preferredPresentMode) :
 		device(device),
 		surface(surface)
 	{
@@ -55,7 +57,7 @@ namespace vmc
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 		createInfo.imageExtent = chooseExtent(capabilities, width, height);
 		createInfo.minImageCount = clamp(3u, capabilities.minImageCount, capabilities.maxImageCount);
-		createInfo.presentMode = choosePresentMode(availablePresentModes);
+		createInfo.presentMode = choosePresentMode(availablePresentModes, preferredPresentMode);
 
 		std::vector<uint32_t> queueFamilyIndices = { device.getGraphicsQueueFamilyIndex(), device.getPresentQueueFamilyIndex() };
 		if (device.getGraphicsQueueFamilyIndex() != device.getPresentQueueFamilyIndex()) {
@@ -85,6 +87,10 @@ namespace vmc
 		extent = createInfo.imageExtent;
 		presentMode = createInfo.presentMode;
 		colorSpace = createInfo.imageColorSpace;
+
+		if (presentMode != preferredPresentMode) {
+			logd("Present mode %d is not supported, falling back to FIFO.", (int)preferredPresentMode);
+		}
 	}
 
 	VulkanSwapchain::VulkanSwapchain(const VulkanSwapchain& oldSwapchain, uint32_t width, uint32_t height) :
@@ -176,4 +182,9 @@ namespace vmc
 	{
 		return surface;
 	}
+
+	VkPresentModeKHR VulkanSwapchain::getPresentMode() const
+	{
+		return presentMode;
+	}
 }
\ No newline at end of file
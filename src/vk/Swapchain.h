@@ -7,7 +7,7 @@ namespace vmc
 	class VulkanSwapchain
 	{
 	public:
-		VulkanSwapchain(const VulkanDevice& device, VkSurfaceFormatKHR surfaceFormat, VkSurfaceKHR surface, uint32_t width, uint32_t height);
+		VulkanSwapchain(const VulkanDevice& device, VkSurfaceFormatKHR surfaceFormat, VkSurfaceKHR surface, uint32_t width, uint32_t height, VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR);
 
 		VulkanSwapchain(const VulkanSwapchain& oldSwapchain, uint32_t width, uint32_t height);
 
@@ -31,6 +31,8 @@ namespace vmc
 
 		VkSurfaceKHR getSurface() const;
 
+		VkPresentModeKHR getPresentMode() const;
+
 	private:
 		const VulkanDevice& device;
 
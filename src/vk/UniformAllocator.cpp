@@ -0,0 +1,128 @@
+#include "UniformAllocator.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace vmc
+{
+	static VkDeviceSize alignOffset(VkDeviceSize offset, VkDeviceSize alignment)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	UniformAllocator::UniformAllocator(const VulkanDevice& device, VkDescriptorSetLayout descriptorSetLayout, VkDeviceSize descriptorRange, VkDeviceSize blockSize) :
+		device(device),
+		descriptorSetLayout(descriptorSetLayout),
+		descriptorRange(descriptorRange),
+		blockSize(blockSize),
+		minAlignment(std::max<VkDeviceSize>(device.getProperties().limits.minUniformBufferOffsetAlignment, 1))
+	{
+		createBlock(blockSize);
+	}
+
+	UniformAllocator::~UniformAllocator()
+	{
+		for (auto& block : blocks) {
+			if (block.data) {
+				block.buffer->unmap();
+			}
+		}
+	}
+
+	void UniformAllocator::reset()
+	{
+		stats.bytesUsedLastFrame = stats.bytesUsedThisFrame;
+		stats.bytesUsedThisFrame = 0;
+
+		for (auto& block : blocks) {
+			block.offset = 0;
+		}
+		currentBlockIndex = 0;
+	}
+
+	UniformAllocation UniformAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		if (size > descriptorRange) {
+			throw std::runtime_error("Cannot allocate uniform larger than the descriptor range.");
+		}
+
+		alignment = std::max(alignment, minAlignment);
+		VkDeviceSize offset = 0;
+
+		while (!tryAllocateFromBlock(blocks[currentBlockIndex], size, alignment, offset)) {
+			if (currentBlockIndex + 1 == blocks.size()) {
+				// Chained blocks double in size, so a frame that outgrew the chain settles after a few frames.
+				createBlock(std::max(blocks.back().buffer->getSize() * 2, alignment + descriptorRange));
+			}
+			currentBlockIndex++;
+		}
+
+		auto& block = blocks[currentBlockIndex];
+		VkDeviceSize usedBefore = block.offset;
+		block.offset = offset + size;
+
+		stats.bytesUsedThisFrame += block.offset - usedBefore;
+		stats.highWaterBytes = std::max(stats.highWaterBytes, stats.bytesUsedThisFrame);
+
+		UniformAllocation allocation;
+		allocation.descriptorSet = block.descriptorSet;
+		allocation.offset = (uint32_t)offset;
+		allocation.data = block.data + offset;
+		return allocation;
+	}
+
+	void UniformAllocator::flush()
+	{
+		for (uint32_t i = 0; i <= currentBlockIndex; i++) {
+			auto& block = blocks[i];
+			if (block.offset > 0 && !block.buffer->isHostCoherent()) {
+				block.buffer->flush(0, block.offset);
+			}
+		}
+	}
+
+	const UniformAllocatorStats& UniformAllocator::getStats() const
+	{
+		return stats;
+	}
+
+	bool UniformAllocator::tryAllocateFromBlock(UniformBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) const
+	{
+		offset = alignOffset(block.offset, alignment);
+
+		// The descriptor always covers descriptorRange bytes past the dynamic offset, so that much has to fit in the block.
+		return offset + descriptorRange <= block.buffer->getSize();
+	}
+
+	UniformBlock& UniformAllocator::createBlock(VkDeviceSize size)
+	{
+		UniformBlock block;
+		block.buffer = std::make_unique<VulkanBuffer>(device, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		block.data = (uint8_t*)block.buffer->map();
+
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		poolSize.descriptorCount = 1;
+		block.descriptorPool = std::make_unique<DescriptorPool>(device, std::vector<VkDescriptorPoolSize>{ poolSize }, 1);
+		block.descriptorSet = block.descriptorPool->allocate(descriptorSetLayout);
+
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = block.buffer->getHandle();
+		bufferInfo.offset = 0;
+		bufferInfo.range = descriptorRange;
+
+		VkWriteDescriptorSet writeInfo{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		writeInfo.descriptorCount = 1;
+		writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		writeInfo.dstBinding = 0;
+		writeInfo.pBufferInfo = &bufferInfo;
+		writeInfo.dstSet = block.descriptorSet;
+
+		vkUpdateDescriptorSets(device.getHandle(), 1, &writeInfo, 0, nullptr);
+
+		stats.blockCount++;
+		stats.allocatedBytes += size;
+
+		blocks.push_back(std::move(block));
+		return blocks.back();
+	}
+}
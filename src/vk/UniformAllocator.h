@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vk/DescriptorPool.h>
+#include <vk/VulkanBuffer.h>
+#include <vector>
+#include <memory>
+#include <cstring>
+
+namespace vmc
+{
+	const VkDeviceSize DefaultUniformBlockSize = 64 * 1024;
+	const VkDeviceSize DefaultUniformDescriptorRange = 256;
+
+	struct UniformAllocation
+	{
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		uint32_t offset = 0;
+		void* data = nullptr;
+	};
+
+	struct UniformBlock
+	{
+		std::unique_ptr<VulkanBuffer> buffer;
+		std::unique_ptr<DescriptorPool> descriptorPool;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		uint8_t* data = nullptr;
+		VkDeviceSize offset = 0;
+	};
+
+	struct UniformAllocatorStats
+	{
+		VkDeviceSize bytesUsedThisFrame = 0;
+		VkDeviceSize bytesUsedLastFrame = 0;
+		VkDeviceSize highWaterBytes = 0;
+		uint32_t blockCount = 0;
+		VkDeviceSize allocatedBytes = 0;
+	};
+
+	// Linear per-frame allocator over persistently mapped uniform blocks. Every block carries its own dynamic uniform
+	// descriptor set, so an allocation is bound with its block's set and the returned dynamic offset.
+	class UniformAllocator
+	{
+	public:
+		UniformAllocator(const VulkanDevice& device, VkDescriptorSetLayout descriptorSetLayout, VkDeviceSize descriptorRange = DefaultUniformDescriptorRange, VkDeviceSize blockSize = DefaultUniformBlockSize);
+
+		UniformAllocator(const UniformAllocator&) = delete;
+
+		UniformAllocator(UniformAllocator&& other) = delete;
+
+		~UniformAllocator();
+
+		UniformAllocator& operator=(const UniformAllocator&) = delete;
+
+		UniformAllocator& operator=(UniformAllocator&&) = delete;
+
+		void reset();
+
+		UniformAllocation allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+
+		template<typename T>
+		UniformAllocation push(const T& value)
+		{
+			auto allocation = allocate(sizeof(T), alignof(T));
+			memcpy(allocation.data, &value, sizeof(T));
+			return allocation;
+		}
+
+		void flush();
+
+		const UniformAllocatorStats& getStats() const;
+
+	private:
+		const VulkanDevice& device;
+
+		VkDescriptorSetLayout descriptorSetLayout;
+
+		VkDeviceSize descriptorRange;
+
+		VkDeviceSize blockSize;
+
+		VkDeviceSize minAlignment;
+
+		std::vector<UniformBlock> blocks;
+
+		uint32_t currentBlockIndex = 0;
+
+		UniformAllocatorStats stats;
+
+		bool tryAllocateFromBlock(UniformBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) const;
+
+		UniformBlock& createBlock(VkDeviceSize size);
+	};
+}
@@ -1,9 +1,10 @@
 #include "VulkanBuffer.h"
 #include <stdexcept>
+#include <algorithm>
 
 namespace vmc
 {
-	VulkanBuffer::VulkanBuffer(const VulkanDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags flags) :
+	VulkanBuffer::VulkanBuffer(const VulkanDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags flags, const std::vector<uint32_t>& queueFamilyIndices) :
 		device(device),
 		size(size)
 	{
@@ -11,6 +12,19 @@ namespace vmc
 		createInfo.usage = usage;
 		createInfo.size = size;
 
+		std::vector<uint32_t> uniqueQueueFamilyIndices;
+		for (auto index : queueFamilyIndices) {
+			if (std::find(uniqueQueueFamilyIndices.begin(), uniqueQueueFamilyIndices.end(), index) == uniqueQueueFamilyIndices.end()) {
+				uniqueQueueFamilyIndices.push_back(index);
+			}
+		}
+
+		if (uniqueQueueFamilyIndices.size() > 1) {
+			createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			createInfo.queueFamilyIndexCount = uniqueQueueFamilyIndices.size();
+			createInfo.pQueueFamilyIndices = uniqueQueueFamilyIndices.data();
+		}
+
 		VmaAllocationCreateInfo memoryInfo{};
 		memoryInfo.flags = flags;
 		memoryInfo.usage = memoryUsage;
@@ -20,13 +34,16 @@ namespace vmc
 		if (vmaCreateBuffer(device.getMemoryAllocator(), &createInfo, &memoryInfo, &handle, &allocation, &allocationInfo) != VK_SUCCESS) {
 			throw std::runtime_error("Cannot create buffer.");
 		}
+
+		vmaGetMemoryTypeProperties(device.getMemoryAllocator(), allocationInfo.memoryType, &memoryProperties);
 	}
 
 	VulkanBuffer::VulkanBuffer(VulkanBuffer&& other) noexcept :
 		device(other.device),
 		size(other.size),
 		allocation(other.allocation),
-		handle(other.handle)
+		handle(other.handle),
+		memoryProperties(other.memoryProperties)
 	{
 		other.handle = VK_NULL_HANDLE;
 		other.allocation = VK_NULL_HANDLE;
@@ -71,6 +88,16 @@ namespace vmc
 		vmaFlushAllocation(device.getMemoryAllocator(), allocation, offset, size);
 	}
 
+	void VulkanBuffer::invalidate(VkDeviceSize offset, VkDeviceSize size)
+	{
+		vmaInvalidateAllocation(device.getMemoryAllocator(), allocation, offset, size);
+	}
+
+	bool VulkanBuffer::isHostCoherent() const
+	{
+		return (memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	}
+
 	void VulkanBuffer::copyFrom(const void* src)
 	{
 		copyFrom(src, 0, size);
@@ -7,7 +7,7 @@ namespace vmc
 	class VulkanBuffer
 	{
 	public:
-		VulkanBuffer(const VulkanDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags flags = 0);
+		VulkanBuffer(const VulkanDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags flags = 0, const std::vector<uint32_t>& queueFamilyIndices = {});
 
 		VulkanBuffer(const VulkanBuffer&) = delete;
 
@@ -31,6 +31,10 @@ namespace vmc
 
 		void flush(VkDeviceSize offset, VkDeviceSize size);
 
+		void invalidate(VkDeviceSize offset, VkDeviceSize size);
+
+		bool isHostCoherent() const;
+
 		void copyFrom(const void* src);
 
 		void copyFrom(const void* src, VkDeviceSize offset, VkDeviceSize size);
@@ -43,5 +47,7 @@ namespace vmc
 		VmaAllocation allocation = VK_NULL_HANDLE;
 
 		VkBuffer handle = VK_NULL_HANDLE;
+
+		VkMemoryPropertyFlags memoryProperties = 0;
 	};
 }
\ No newline at end of file
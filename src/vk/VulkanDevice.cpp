@@ -1,6 +1,8 @@
 #include "VulkanDevice.h"
 #include <stdexcept>
 #include <set>
+#include <cstring>
+#include <algorithm>
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
 
@@ -8,6 +10,10 @@ namespace vmc
 {
 	std::vector<VkSurfaceFormatKHR> getFormats(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface)
 	{
+		if (surface == VK_NULL_HANDLE) {
+			return {};
+		}
+
 		uint32_t count;
 		vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &count, nullptr);
 
@@ -18,6 +24,11 @@ namespace vmc
 
 	VkSurfaceFormatKHR chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
 	{
+		// Without a surface every format is available, so offscreen targets use the preferred swapchain format.
+		if (availableFormats.empty()) {
+			return { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+		}
+
 		for (const auto& surfaceFormat : availableFormats) {
 			if (surfaceFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR && surfaceFormat.format == VK_FORMAT_B8G8R8A8_UNORM) {
 				return surfaceFormat;
@@ -60,6 +71,16 @@ namespace vmc
 		throw std::runtime_error("Cannot find requested queue family.");
 	}
 
+	std::vector<VkExtensionProperties> getAvailableDeviceExtensions(VkPhysicalDevice physicalDevice)
+	{
+		uint32_t count;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, nullptr);
+
+		std::vector<VkExtensionProperties> extensions(count);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, extensions.data());
+		return extensions;
+	}
+
 	VkFormat chooseDepthFormat(VkPhysicalDevice physicalDevice)
 	{
 		static std::vector<VkFormat> candidates = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
@@ -77,7 +98,7 @@ namespace vmc
 		throw std::runtime_error("Cannot find depth format for device.");
 	}
 
-	VulkanDevice::VulkanDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const std::vector<const char*> requiredDeviceExtensions) :
+	VulkanDevice::VulkanDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const std::vector<const char*> requiredDeviceExtensions, const std::vector<const char*>& optionalDeviceExtensions) :
 		physicalDevice(physicalDevice)
 	{
 		uint32_t queueFamiliesCount = 0;
@@ -86,19 +107,28 @@ namespace vmc
 		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamiliesCount);
 		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamiliesCount, queueFamilies.data());
 
+		// A device created without a surface renders offscreen and never presents, its present queue is the graphics queue.
 		std::set<uint32_t> usedQueueFamilyIndices;
-		presentQueueFamilyIndex = findPresentQueueFamilyIndex(physicalDevice, surface);
-		usedQueueFamilyIndices.insert(presentQueueFamilyIndex);
+		if (surface != VK_NULL_HANDLE) {
+			presentQueueFamilyIndex = findPresentQueueFamilyIndex(physicalDevice, surface);
+			usedQueueFamilyIndices.insert(presentQueueFamilyIndex);
+		}
 
 		graphicsQueueFamilyIndex = findQueueFamilyIndex(queueFamilies, VK_QUEUE_GRAPHICS_BIT, usedQueueFamilyIndices);
 		usedQueueFamilyIndices.insert(graphicsQueueFamilyIndex);
 
+		if (surface == VK_NULL_HANDLE) {
+			presentQueueFamilyIndex = graphicsQueueFamilyIndex;
+		}
+
 		transferQueueFamilyIndex = findQueueFamilyIndex(queueFamilies, VK_QUEUE_TRANSFER_BIT, usedQueueFamilyIndices);
 		usedQueueFamilyIndices.insert(transferQueueFamilyIndex);
 
 		computeQueueFamilyIndex = findQueueFamilyIndex(queueFamilies, VK_QUEUE_COMPUTE_BIT, usedQueueFamilyIndices);
 		usedQueueFamilyIndices.insert(computeQueueFamilyIndex);
 
+		graphicsQueueComputeSupported = (queueFamilies[graphicsQueueFamilyIndex].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+
 		float queuePriority = 1.0f;
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		for (auto familyIndex : usedQueueFamilyIndices) {
@@ -109,14 +139,33 @@ namespace vmc
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
-		VkPhysicalDeviceFeatures requiredFeatures{};
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+		enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+		auto extensions = requiredDeviceExtensions;
+		auto availableExtensions = getAvailableDeviceExtensions(physicalDevice);
+		for (auto extension : optionalDeviceExtensions) {
+			for (const auto& availableExtension : availableExtensions) {
+				if (strcmp(availableExtension.extensionName, extension) == 0) {
+					extensions.push_back(extension);
+					break;
+				}
+			}
+		}
+
+		for (auto extension : extensions) {
+			enabledExtensions.push_back(extension);
+		}
 
 		VkDeviceCreateInfo deviceInfo{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
-		deviceInfo.enabledExtensionCount = requiredDeviceExtensions.size();
-		deviceInfo.ppEnabledExtensionNames = requiredDeviceExtensions.data();
+		deviceInfo.enabledExtensionCount = extensions.size();
+		deviceInfo.ppEnabledExtensionNames = extensions.data();
 		deviceInfo.queueCreateInfoCount = queueCreateInfos.size();
 		deviceInfo.pQueueCreateInfos = queueCreateInfos.data();
-		deviceInfo.pEnabledFeatures = &requiredFeatures;
+		deviceInfo.pEnabledFeatures = &enabledFeatures;
 
 		if (vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &handle) != VK_SUCCESS) {
 			throw std::runtime_error("Cannot initialize vulkan device.");
@@ -133,6 +182,10 @@ namespace vmc
 		surfaceFormat = chooseSurfaceFormat(availableFormats);
 		depthFormat = chooseDepthFormat(physicalDevice);
 
+		VkFormatProperties depthFormatProperties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, depthFormat, &depthFormatProperties);
+		depthSamplingSupported = (depthFormatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+
 		VmaVulkanFunctions vmaFunctions{};
 		vmaFunctions.vkAllocateMemory = vkAllocateMemory;
 		vmaFunctions.vkBindBufferMemory = vkBindBufferMemory;
@@ -175,7 +228,11 @@ namespace vmc
 		computeQueueFamilyIndex(other.computeQueueFamilyIndex),
 		surfaceFormat(other.surfaceFormat),
 		memoryAllocator(other.memoryAllocator),
-		properties(properties)
+		properties(properties),
+		enabledFeatures(other.enabledFeatures),
+		enabledExtensions(std::move(other.enabledExtensions)),
+		graphicsQueueComputeSupported(other.graphicsQueueComputeSupported),
+		depthSamplingSupported(other.depthSamplingSupported)
 	{
 		other.handle = VK_NULL_HANDLE;
 		other.memoryAllocator = VK_NULL_HANDLE;
@@ -263,6 +320,26 @@ namespace vmc
 		return properties;
 	}
 
+	const VkPhysicalDeviceFeatures& VulkanDevice::getEnabledFeatures() const
+	{
+		return enabledFeatures;
+	}
+
+	bool VulkanDevice::isExtensionEnabled(const std::string& name) const
+	{
+		return std::find(enabledExtensions.begin(), enabledExtensions.end(), name) != enabledExtensions.end();
+	}
+
+	bool VulkanDevice::isGraphicsQueueComputeSupported() const
+	{
+		return graphicsQueueComputeSupported;
+	}
+
+	bool VulkanDevice::isDepthSamplingSupported() const
+	{
+		return depthSamplingSupported;
+	}
+
 	void VulkanDevice::waitIdle() const
 	{
 		vkDeviceWaitIdle(handle);
@@ -3,13 +3,14 @@
 #include <volk.h>
 #include <vk_mem_alloc.h>
 #include <vector>
+#include <string>
 
 namespace vmc
 {
 	class VulkanDevice
 	{
 	public:
-		VulkanDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const std::vector<const char*> requiredDeviceExtensions);
+		VulkanDevice(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const std::vector<const char*> requiredDeviceExtensions, const std::vector<const char*>& optionalDeviceExtensions = {});
 
 		VulkanDevice(const VulkanDevice&) = delete;
 
@@ -49,6 +50,14 @@ namespace vmc
 
 		const VkPhysicalDeviceProperties& getProperties() const;
 
+		const VkPhysicalDeviceFeatures& getEnabledFeatures() const;
+
+		bool isExtensionEnabled(const std::string& name) const;
+
+		bool isGraphicsQueueComputeSupported() const;
+
+		bool isDepthSamplingSupported() const;
+
 		void waitIdle() const;
 
 	private:
@@ -79,5 +88,13 @@ namespace vmc
 		VmaAllocator memoryAllocator = VK_NULL_HANDLE;
 
 		VkPhysicalDeviceProperties properties;
+
+		VkPhysicalDeviceFeatures enabledFeatures{};
+
+		std::vector<std::string> enabledExtensions;
+
+		bool graphicsQueueComputeSupported = false;
+
+		bool depthSamplingSupported = false;
 	};
 }
\ No newline at end of file
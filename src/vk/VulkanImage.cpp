@@ -46,7 +46,10 @@ namespace vmc
         device(other.device),
         allocation(other.allocation),
         handle(other.handle),
-        format(other.format)
+        format(other.format),
+        width(other.width),
+        height(other.height),
+        mipLevels(other.mipLevels)
     {
         other.handle = VK_NULL_HANDLE;
         other.allocation = VK_NULL_HANDLE;
@@ -89,7 +92,7 @@ namespace vmc
     {
     }
 
-    VulkanImageView::VulkanImageView(const VulkanDevice& device, VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t mipLevels) :
+    VulkanImageView::VulkanImageView(const VulkanDevice& device, VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t mipLevels, uint32_t baseMipLevel) :
         device(device)
     {
         VkImageViewCreateInfo createInfo = {};
@@ -98,7 +101,7 @@ namespace vmc
         createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
         createInfo.format = format;
         createInfo.subresourceRange.aspectMask = aspect;
-        createInfo.subresourceRange.baseMipLevel = 0;
+        createInfo.subresourceRange.baseMipLevel = baseMipLevel;
         createInfo.subresourceRange.levelCount = mipLevels;
         createInfo.subresourceRange.baseArrayLayer = 0;
         createInfo.subresourceRange.layerCount = 1;
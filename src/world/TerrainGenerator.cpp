@@ -1,4 +1,5 @@
 #include "TerrainGenerator.h"
+#include <common/Profiler.h>
 
 namespace vmc
 {
@@ -10,6 +11,7 @@ namespace vmc
 
     void TerrainGenerator::generateChunk(Chunk& chunk, const glm::ivec2& chunkOffset) const
     {
+        VMC_PROFILE_ZONE("generate terrain");
         int32_t maxHeight = 64;
         int32_t minHeight = 32;
         float gridSize = 64.0f;
@@ -42,4 +42,9 @@ namespace vmc
         terrainGenerator.generateChunk(chunks[coordinate], coordinate);
         return chunks[coordinate];
     }
-}
+
+    void World::unloadChunk(const glm::ivec2& coordinate)
+    {
+        chunks.erase(coordinate);
+    }
+}
\ No newline at end of file
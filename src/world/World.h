@@ -34,6 +34,8 @@ namespace vmc
 
         Chunk& generateChunk(const glm::ivec2& coordinate);
 
+        void unloadChunk(const glm::ivec2& coordinate);
+
     private:
         std::unordered_map<glm::ivec2, Chunk> chunks;
 